@@ -1,8 +1,11 @@
-bin_PROGRAMS          = reversi-demo ttt-demo 
+bin_PROGRAMS          = reversi-demo reversi-probcut ttt-demo 
 
 reversi_demo_SOURCES  = examples/reversi-demo.c
 reversi_demo_LDFLAGS  = -L$(builddir) -lreversi
 
+reversi_probcut_SOURCES = examples/reversi-probcut.c
+reversi_probcut_LDFLAGS = -L$(builddir) -lreversi -lm
+
 ttt_demo_SOURCES      = examples/ttt-demo.c
 ttt_demo_LDFLAGS      = -L$(builddir) -lggtl
 
@@ -14,10 +17,17 @@ examples/reversi-demo.c: examples/reversi-demo.pod
 	-mkdir -p $@ && rmdir $@
 	sed 's/^=for //' $< > $@
 
+examples/reversi-probcut.c: examples/reversi-probcut.pod
+	-mkdir -p $@ && rmdir $@
+	sed 's/^=for //' $< > $@
+
 man3_MANS            += examples/reversi-demo.man \
+                        examples/reversi-probcut.man \
                         examples/ggtltut.man
 
 EXTRA_DIST           += examples/reversi-demo.pod \
+                        examples/reversi-probcut.pod \
                         examples/ggtltut.pod
 
-CLEANFILES           += $(reversi_demo_SOURCES) $(ttt_demo_SOURCES) 
+CLEANFILES           += $(reversi_demo_SOURCES) $(reversi_probcut_SOURCES) \
+                        $(ttt_demo_SOURCES) 
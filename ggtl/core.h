@@ -23,6 +23,8 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #ifndef ggtl__core_h
 #define ggtl__core_h
 
+#include <stdio.h>
+
 #ifdef __cplusplus      /* let C++ coders use this library */
 extern "C" {
 #endif
@@ -38,11 +40,45 @@ enum {          /* keys valid for ggtl_set() */
   TRACE,        /* tracing level */
   CACHE,        /* what to cache */
   TIME,	        /* seconds (float) for iterative AI */
+  TT_SIZE,      /* number of transposition table entries */
+  ASPIRATION,   /* aspiration window width for iterative AI */
+  ASP_GROWTH,   /* factor to widen aspiration window by on failure */
+  POLL,         /* states to visit between checking the clock */
+  HARD_DEADLINE,/* abort searches that run out of time */
+  KILLERS,      /* use killer move heuristic */
+  HISTORY,      /* use history heuristic */
+  QS_DEPTH,     /* max depth of quiescence search */
+  QS_NODES,     /* max states visited by quiescence search */
+  NULL_MOVE,    /* depth reduction for null-move pruning */
+  LMR,          /* moves to search before late move reductions */
+  LMR_DEPTH,    /* min depth left for late move reductions */
+  FUTILITY,     /* margin per ply for futility pruning */
+  FUTILITY_DEPTH, /* max depth left for futility pruning */
+  PROBCUT,      /* ProbCut threshold (float) */
+  THREADS,      /* threads for parallel AIs */
+  ROOT_PARALLEL,/* split root moves among threads */
+  SEED,         /* seed for the RANDOM AI's generator */
+  TT_SHM,       /* shared-memory segment for the TT (string) */
+  ARENA,        /* nodes in the first slab of the node arena */
   SET_KEYS,
 };
 enum {          /* additional keys valid for ggtl_get() */
   VISITED = SET_KEYS, /* number of states visited during last search */
   PLY_REACHED,  /* depth reached by last iterative search */
+  TT_HITS,      /* transposition table hits during last search */
+  TT_MISSES,    /* transposition table misses during last search */
+  OVERSHOOT,    /* microseconds the last search went past TIME */
+  CUTOFFS,      /* beta cutoffs during last search */
+  FIRST_CUTOFFS,/* beta cutoffs by the first move searched */
+  QS_VISITED,   /* states visited by quiescence search */
+  NULL_CUTOFFS, /* null-move cutoffs during last search */
+  LMR_REDUCED,  /* moves searched with reduced depth */
+  FUTILITY_PRUNED, /* moves skipped by futility pruning */
+  SCORE,        /* score of the move picked by last search */
+  PROBCUT_CUTS, /* cutoffs by ProbCut during last search */
+  NPS,          /* states visited per second by last iterative search */
+  TT_SHARED_HITS, /* TT hits on entries stored by other processes */
+  MALLOCS,      /* blocks allocated during last search */
   GET_KEYS,
 };
 
@@ -52,6 +88,21 @@ enum {
   RANDOM,
   FIXED,
   ITERATIVE,
+  PVS,
+  MTDF,
+  YBWC,
+};
+
+/* keys valid for ggtl_pool_get() */
+enum {
+  POOL_JOBS = 0,        /* jobs finished */
+  POOL_QUEUED,          /* jobs waiting for a thread */
+  POOL_WAIT,            /* mean seconds jobs waited for a thread */
+  POOL_MAX_WAIT,        /* longest wait */
+  POOL_LATENCY,         /* mean seconds from submitting to finishing */
+  POOL_MAX_LATENCY,     /* longest latency */
+  POOL_LATE,            /* jobs finished after their deadline */
+  POOL_KEYS,
 };
 
 /* fitness limits */
@@ -61,7 +112,14 @@ enum {
 #define FITNESS_MAX GGTL_FITNESS_MAX  /* backward compat */
 #define FITNESS_MIN GGTL_FITNESS_MIN  /* backward compat */
 
+/* move_key() callback values must be below this */
+#define GGTL_MOVE_KEYS 4096
+
+/* room for a move packed into its GGTL_MOVE (ggtl_wrap_packed()) */
+#define GGTL_PACKED_SIZE 8
+
 typedef struct ggtl GGTL;
+typedef struct ggtl_pool GGTL_POOL;
 
 typedef struct ggtl_sc {
   struct ggtl_sc *next;
@@ -72,6 +130,12 @@ typedef struct ggtl_mc {
   struct ggtl_mc *next;
   int fitness;
   void *data;
+  union {               /* data points here for packed moves, which
+                         * can't be freed or outlive the node */
+    long i;
+    void *p;
+    unsigned char c[GGTL_PACKED_SIZE];
+  } packed;
 } GGTL_MOVE;
 
 typedef struct ggtl_vtab {
@@ -83,6 +147,18 @@ typedef struct ggtl_vtab {
   void *(*clone_state)(void *, GGTL *);
   void (*free_state)(void *);
   void (*free_move)(void *);
+  unsigned long (*hash)(void *, GGTL *);
+  int (*move_key)(void *, GGTL *);
+  GGTL_MOVE *(*get_noisy_moves)(void *, GGTL *);
+  void *(*null_move)(void *, GGTL *);
+  void *(*null_unmove)(void *, GGTL *);
+  int (*serialize)(void *, unsigned char *, int, GGTL *);
+  void *(*deserialize)(const unsigned char *, int, GGTL *);
+  int (*get_moves_array)(void *, void *, int, GGTL *);
+  int move_size;
+  int state_size;
+  void (*release_state)(void *, GGTL *);
+  void (*release_move)(void *, GGTL *);
 } GGTL_VTAB;
 
 /* ggtl/core.c */
@@ -90,11 +166,25 @@ GGTL *ggtl_new(void);
 GGTL_STATE *ggtl_sc_new(void *);
 GGTL_MOVE *ggtl_mc_new(void *);
 GGTL *ggtl_init(GGTL *g, void *s);
+GGTL *ggtl_fork(GGTL *g);
+GGTL *ggtl_fork_internal(GGTL *g);
+void ggtl_join(GGTL *g, GGTL *fork);
 GGTL_VTAB *ggtl_vtab(GGTL *g);
 void *ggtl_peek_state(GGTL *g);
 void *ggtl_peek_move(GGTL *g);
 void *ggtl_move(GGTL *g, void *m);
 void *ggtl_ai_move(GGTL *g);
+int ggtl_ai_move_start(GGTL *g, void (*done)(GGTL *, void *, void *),
+                       void *data);
+int ggtl_ai_move_poll(GGTL *g);
+void ggtl_stop(GGTL *g);
+int ggtl_ponder_start(GGTL *g);
+void *ggtl_ponder_move(GGTL *g);
+void ggtl_ponder_stop(GGTL *g);
+int ggtl_search_begin(GGTL *g);
+int ggtl_search_step(GGTL *g, int max_states);
+void *ggtl_search_result(GGTL *g);
+void *ggtl_search_end(GGTL *g);
 GGTL_MOVE *ggtl_get_moves(GGTL *g);
 GGTL_STATE *ggtl_move_internal(GGTL *g, GGTL_MOVE *m);
 GGTL_MOVE *ggtl_undo_internal(GGTL *g);
@@ -106,6 +196,7 @@ void ggtl_cache_move(GGTL *g, void *move);
 void ggtl_cache_free(GGTL *g);
 GGTL_STATE *ggtl_wrap_state(GGTL *g, void *s);
 GGTL_MOVE *ggtl_wrap_move(GGTL *g, void *m);
+GGTL_MOVE *ggtl_wrap_packed(GGTL *g);
 GGTL_STATE *ggtl_uncache_state(GGTL *g);
 GGTL_MOVE *ggtl_uncache_move(GGTL *g);
 void *ggtl_uncache_state_raw(GGTL *g);
@@ -117,6 +208,26 @@ void ggtl_set(GGTL *g, int key, int value);
 int ggtl_get(GGTL *g, int key);
 void ggtl_set_float(GGTL *g, int key, float value);
 float ggtl_get_float(GGTL *g, int key);
+void ggtl_set_string(GGTL *g, int key, const char *value);
+int ggtl_probcut_load(GGTL *g, const char *path);
+int ggtl_get_thread(GGTL *g, int thread, int key);
+void ggtl_set_trace(GGTL *g, FILE *fp);
+void ggtl_set_allocator(GGTL *g, void *(*alloc)(size_t, void *),
+                        void (*dealloc)(void *, void *), void *ctx);
+void *ggtl_alloc(GGTL *g, size_t size);
+void ggtl_dealloc(GGTL *g, void *block);
+
+int ggtl_listen(const char *addr);
+int ggtl_connect(const char *addr);
+int ggtl_serve(GGTL *g, int fd);
+int ggtl_add_worker(GGTL *g, int fd);
+
+GGTL_POOL *ggtl_pool_new(int threads);
+int ggtl_pool_submit(GGTL_POOL *p, GGTL *g,
+                     void (*done)(GGTL *, void *, void *), void *data);
+void ggtl_pool_wait(GGTL_POOL *p);
+double ggtl_pool_get(GGTL_POOL *p, int key);
+void ggtl_pool_free(GGTL_POOL *p);
 
 #ifdef __cplusplus
 }
@@ -23,6 +23,7 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <string.h>
 #include <assert.h>
 
 #include <sl/sl.h>
@@ -48,6 +49,9 @@ GGTL - Generic Game-Tree search Library
   GGTL_VTAB *ggtl_vtab(GGTL *g);
   void ggtl_free(GGTL *g);
   
+  GGTL *ggtl_fork(GGTL *g);
+  void ggtl_join(GGTL *g, GGTL *fork);
+  
   void *ggtl_move(GGTL *g, void *m);
   void *ggtl_ai_move(GGTL *g);
   void *ggtl_undo(GGTL *g);
@@ -56,6 +60,12 @@ GGTL - Generic Game-Tree search Library
   int ggtl_get(GGTL *g, int key);
   void ggtl_set_float(GGTL *g, int key, float value);
   float ggtl_get_float(GGTL *g, int key);
+  int ggtl_probcut_load(GGTL *g, const char *path);
+  int ggtl_get_thread(GGTL *g, int thread, int key);
+  void ggtl_set_allocator(GGTL *g, void *(*alloc)(size_t, void *),
+                          void (*dealloc)(void *, void *), void *ctx);
+  void *ggtl_alloc(GGTL *g, size_t size);
+  void ggtl_dealloc(GGTL *g, void *block);
   
   void *ggtl_peek_state(GGTL *g);
   void *ggtl_peek_move(GGTL *g);
@@ -66,6 +76,7 @@ GGTL - Generic Game-Tree search Library
   
   GGTL_STATE *ggtl_wrap_state(GGTL *g, void *state);
   GGTL_MOVE *ggtl_wrap_move(GGTL *g, void *move);
+  GGTL_MOVE *ggtl_wrap_packed(GGTL *g);
   
   void ggtl_cache_states(GGTL *g, GGTL_STATE *list);
   void ggtl_cache_state(GGTL *g, void *state);
@@ -110,7 +121,8 @@ are often wrapped in C<GGTL_STATE> containers and moves in
 C<GGTL_MOVE> containers. These structures have a C<next>
 member pointing to the next node in the chain, and a C<data>
 member pointing to the state or move. See C<ggtl_wrap_state()> &
-C<ggtl_wrap_move()>.
+C<ggtl_wrap_move()>. Small moves can instead be packed into the
+C<GGTL_MOVE> itself; see C<ggtl_wrap_packed()>.
 
 The L<sl(3)|sl> library is used to manage lists internally. See
 its documentation for details if you are developing your own
@@ -152,9 +164,11 @@ Returns a new ggtl structure, or NULL on failure.
 GGTL *ggtl_new(void)
 {
   GGTL *g;
+  int i;
 
   g = malloc( sizeof *g );
   if (g) {
+    ggtl_set_allocator(g, NULL, NULL, NULL);
     g->vtab = malloc( sizeof(GGTL_VTAB) );
     if (g->vtab) {
       g->vtab->eval = NULL;
@@ -163,22 +177,103 @@ GGTL *ggtl_new(void)
       g->vtab->get_moves = NULL;
       g->vtab->game_over = NULL;
       g->vtab->clone_state = NULL;
+      g->vtab->hash = NULL;
+      g->vtab->move_key = NULL;
+      g->vtab->get_noisy_moves = NULL;
+      g->vtab->null_move = NULL;
+      g->vtab->null_unmove = NULL;
+      g->vtab->serialize = NULL;
+      g->vtab->deserialize = NULL;
+      g->vtab->get_moves_array = NULL;
+      g->vtab->move_size = 0;
+      g->vtab->state_size = 0;
 
       g->vtab->free_state = &free;
       g->vtab->free_move = &free;
+      g->vtab->release_state = NULL;
+      g->vtab->release_move = NULL;
     }
     else {
-      ggtl_free( g );
+      /* nothing else is set up yet, so ggtl_free() can't be used */
+      free( g );
       return NULL;
     }
     g->states = g->state_cache = g->sc_cache = NULL;
     g->moves = g->move_cache = g->mc_cache = NULL;
+    g->tt = NULL;
+    g->tt_age = 0;
+    g->tt_shm = NULL;
+    g->tt_mapped = 0;
+    g->tt_owner = 0;
+    g->opts[TT_SHM] = 0;
+    g->killers = g->history = NULL;
+    g->killer_plies = 0;
+    g->pvs = 0;
+    g->fail_soft = 0;
+    g->in_probcut = 0;
+    for (i = 0; i < PROBCUT_DEPTHS; i++) {
+      g->probcut[i].shallow = 0;
+    }
+    g->helpers = NULL;
+    g->nhelpers = 0;
+    g->sync = NULL;
+    g->smp_stop = 0;
+    g->stop = NULL;
+    g->master = NULL;
+    g->ybwc = g->root_parallel = 0;
+    g->split = NULL;
+    g->trace = stdout;
+    g->async = NULL;
+    g->halt = 0;
+    g->ponder = NULL;
+    g->ponder_move = NULL;
+    g->ponder_copy = NULL;
+    g->ponder_key = 0;
+    g->pondering = 0;
+    g->ponder_hit = 0;
+    g->started = 0;
+    g->inc = NULL;
+    g->node_limit = 0;
+    g->workers = NULL;
+    g->nworkers = 0;
+    g->plybufs = NULL;
+    g->nplybufs = 0;
+    g->ply_depth = 0;
+    g->frames = NULL;
+    g->nframes = 0;
+    g->frame_depth = 0;
+    g->slabs = NULL;
+    g->slab_used = 0;
+    g->spare = NULL;
+    g->arena_on = 0;
+    g->stacks = g->stack = NULL;
     ggtl_set(g, CACHE, STATES | MOVES); /* cache both */
 
     ggtl_set(g, TYPE, ITERATIVE);   /* the fixed-depth AI */
     ggtl_set(g, PLY, 3);            /* ply 3 */
     ggtl_set_float(g, TIME, 0.2);   /* 200 ms */
     ggtl_set(g, TRACE, 0);          /* no trace output */
+    ggtl_set(g, TT_SIZE, 0);        /* no transposition table */
+    ggtl_set(g, ASPIRATION, 0);     /* full-width iterations */
+    ggtl_set(g, ASP_GROWTH, 4);     /* widen windows fourfold */
+    ggtl_set(g, POLL, 1000);        /* check clock every 1000 states */
+    ggtl_set(g, HARD_DEADLINE, 0);  /* finish iterations started */
+    g->deadline = 0;
+    g->aborted = 0;
+    ggtl_set(g, KILLERS, 0);        /* no killer moves */
+    ggtl_set(g, HISTORY, 0);        /* no history heuristic */
+    ggtl_set(g, QS_DEPTH, 8);       /* quiescence search 8 ply deep */
+    ggtl_set(g, QS_NODES, 0);       /* ... visiting any number of states */
+    ggtl_set(g, NULL_MOVE, 0);      /* no null-move pruning */
+    ggtl_set(g, LMR, 0);            /* no late move reductions */
+    ggtl_set(g, LMR_DEPTH, 2);
+    ggtl_set(g, FUTILITY, 0);       /* no futility pruning */
+    ggtl_set(g, FUTILITY_DEPTH, 1);
+    ggtl_set_float(g, PROBCUT, 0.0); /* no ProbCut */
+    ggtl_set(g, THREADS, 1);        /* no helper threads */
+    ggtl_set(g, ROOT_PARALLEL, 0);  /* ... or if any, not at the root */
+    ggtl_set(g, SEED, 1);           /* same random moves every run */
+    ggtl_set(g, ARENA, 0);          /* nodes allocated one at a time */
   }
   
   return g;
@@ -196,12 +291,29 @@ Free the memory held in a ggtl struct.
 
 void ggtl_free( GGTL *g )
 {
-  ggtl_cache_states(g, g->states);
+  GGTL_STATE *s;
+
+  ggtl_ponder_stop(g);
+  ggtl_stop(g);
+  (void)ai_end(g, 0);
+  while ((s = sl_pop(&g->states))) {
+    if (!stack_pop(g, s)) {
+      ggtl_cache_states(g, s);
+    }
+  }
   ggtl_cache_moves(g, g->moves);
-  g->states = NULL;
   g->moves = NULL;
 
   ggtl_cache_free(g);
+  arena_free(g);
+  stack_free(g);
+  smp_free(g);
+  net_free(g);
+  ply_free(g);
+  ggtl_dealloc(g, g->ponder_copy);
+  tt_free(g);
+  (void)tt_share(g, NULL);
+  order_free(g);
   free(g->vtab);
   free(g);
 }
@@ -243,6 +355,119 @@ GGTL_VTAB *ggtl_vtab( GGTL *g )
 
 /*
 
+=item GGTL *ggtl_fork( *g )
+
+Returns a new GGTL structure set up to play the same game as C<g>
+from its current position, with the same vtable and options, or
+NULL on failure. Its random number generator starts where that of
+C<g> is. The fork gets its own copy of the current state,
+made with the C<clone_state()> callback (see L<ggtlcb(3)|ggtlcb>),
+which must be provided. It also gets its own caches, move ordering
+tables and transposition table, so the fork and C<g> can be used
+from different threads at the same time.
+
+The fork cannot undo moves made before it was forked. Moves and
+states cached by C<g> are not copied.
+
+=cut
+
+*/
+
+GGTL *ggtl_fork(GGTL *g)
+{
+  GGTL *f = ggtl_fork_internal(g);
+
+  if (f && g->tt) {
+    ggtl_set(f, TT_SIZE, ggtl_get(g, TT_SIZE));
+  }
+  return f;
+}
+
+/*
+
+=begin internal
+
+=item GGTL *ggtl_fork_internal( *g )
+
+Like C<ggtl_fork()>, but the fork does not get a transposition
+table. The C<TT_SIZE> option is still copied, so the table of C<g>
+can be shared by setting the fork's C<tt> member to it.
+
+=end internal
+
+=cut
+
+*/
+
+GGTL *ggtl_fork_internal(GGTL *g)
+{
+  GGTL_VTAB *v = ggtl_vtab(g);
+  GGTL *f;
+  void *s;
+
+  if (!v->clone_state || !ggtl_peek_state(g)) {
+    return NULL;
+  }
+
+  f = ggtl_new();
+  if (!f) {
+    return NULL;
+  }
+
+  *ggtl_vtab(f) = *v;
+  ggtl_set_allocator(f, g->alloc, g->dealloc, g->alloc_ctx);
+  memcpy(f->opts, g->opts, sizeof f->opts);
+  memcpy(f->probcut, g->probcut, sizeof f->probcut);
+  f->probcut_t = g->probcut_t;
+  f->time_to_search = g->time_to_search;
+  f->tt_age = g->tt_age;
+  f->tt_owner = g->tt_owner;
+  (void)tt_share(f, g->tt_shm);
+  f->rng = g->rng;
+  f->trace = g->trace;
+
+  s = v->clone_state(ggtl_peek_state(g), f);
+  if (!s || !ggtl_init(f, s)) {
+    if (s) {
+      state_release(f, s);
+    }
+    ggtl_free(f);
+    return NULL;
+  }
+  return f;
+}
+
+/*
+
+=item void ggtl_join( *g, *fork )
+
+Adds the counts of states visited, cutoffs and so on (see
+L<Run-time options>) from the last search made by C<fork> to those
+of C<g>, and frees C<fork>. This is for when a search is shared
+among several forks, and the work of all of them should be
+reported by C<ggtl_get(g, VISITED)> and friends.
+
+=cut
+
+*/
+
+void ggtl_join(GGTL *g, GGTL *f)
+{
+  static const int keys[] = {
+    VISITED, TT_HITS, TT_MISSES, CUTOFFS, FIRST_CUTOFFS, QS_VISITED,
+    NULL_CUTOFFS, LMR_REDUCED, FUTILITY_PRUNED, PROBCUT_CUTS,
+    TT_SHARED_HITS, MALLOCS
+  };
+  unsigned i;
+
+  for (i = 0; i < sizeof keys / sizeof keys[0]; i++) {
+    g->opts[keys[i]] += f->opts[keys[i]];
+  }
+  ggtl_free(f);
+}
+
+/*
+
 =back
 
 =head2 Moving and undo
@@ -259,6 +484,10 @@ Upon success, the move is stored in a history list. If
 the C<unmove()> callback is not provided, the previous state is
 also stored in order to provide undo.
 
+If C<g> is pondering (see C<ggtl_ponder_start()>) and this is
+the move pondered on, pondering goes on; otherwise it is ended.
+An incremental search (see C<ggtl_search_begin()>) is ended.
+
 =cut
 
 */
@@ -266,7 +495,10 @@ also stored in order to provide undo.
 void *ggtl_move( GGTL *g, void *m )
 {
   GGTL_STATE *ns = NULL;
-  GGTL_MOVE *nm = ggtl_wrap_move(g, m);
+  GGTL_MOVE *nm;
+
+  (void)ai_end(g, 0);
+  nm = ggtl_wrap_move(g, m);
 
   if (nm) {
     ns = ggtl_move_internal(g, nm);
@@ -275,6 +507,16 @@ void *ggtl_move( GGTL *g, void *m )
       g->mc_cache = sl_push(g->mc_cache, nm);
     }
   }
+
+  if (g->ponder) {
+    if (ns && !g->ponder->ponder_hit
+        && g->vtab->hash(ns->data, g) == g->ponder_key) {
+      g->ponder->ponder_hit = 1;
+    }
+    else {
+      ggtl_ponder_stop(g);
+    }
+  }
     
   return ns ? ggtl_peek_state(g) : NULL;
 }
@@ -298,6 +540,7 @@ container.
 GGTL_STATE *ggtl_move_internal( GGTL *g, GGTL_MOVE *m )
 {
   GGTL_VTAB *v = ggtl_vtab(g);
+  GGTL_STATE *n = NULL;
   void *s = ggtl_peek_state(g);
   
   if (v->unmove) {
@@ -308,14 +551,26 @@ GGTL_STATE *ggtl_move_internal( GGTL *g, GGTL_MOVE *m )
     return NULL;
   }
 
-  if (v->clone_state) { 
+  if (v->state_size > 0) {
+    /* copy-make on the state stack */
+    n = stack_push(g);
+    if (!n) {
+      return NULL;
+    }
+    s = memcpy(n->data, s, v->state_size);
+  }
+  else if (v->clone_state) { 
     s = v->clone_state(s, g);
   }
   assert(s != NULL);
   
   s = v->move(s, m->data, g);
+  if (n && s != n->data) {
+    (void)stack_pop(g, n);
+    n = NULL;
+  }
   if (s) {
-    g->states = sl_push(g->states, ggtl_wrap_state(g, s));
+    g->states = sl_push(g->states, n ? n : ggtl_wrap_state(g, s));
     g->moves = sl_push(g->moves, m);
   }
 
@@ -336,13 +591,33 @@ so the AI's moves can also be undone.
 
 */
 
-void *ggtl_ai_move(GGTL *g)
+/* Get ready for a new search */
+static void ai_reset(GGTL *g)
+{
+  g->opts[VISITED] = 0;
+  g->opts[TT_HITS] = g->opts[TT_MISSES] = 0;
+  g->opts[TT_SHARED_HITS] = 0;
+  g->opts[OVERSHOOT] = 0;
+  g->opts[CUTOFFS] = g->opts[FIRST_CUTOFFS] = 0;
+  g->opts[QS_VISITED] = 0;
+  g->opts[NULL_CUTOFFS] = g->opts[LMR_REDUCED] = 0;
+  g->opts[FUTILITY_PRUNED] = g->opts[PROBCUT_CUTS] = 0;
+  g->opts[NPS] = 0;
+  g->opts[MALLOCS] = 0;
+  g->tt_age++;
+  order_reset(g);
+  smp_free(g);
+}
+
+static void *ai_move(GGTL *g)
 {
   GGTL_MOVE *moves, *move;
   GGTL_STATE *state;
 
   assert(g != NULL);
-  g->opts[VISITED] = 0;
+  (void)ai_end(g, 0);
+  ai_reset(g);
+  arena_start(g);
 
   move = NULL;
   moves = ggtl_get_moves(g);
@@ -360,6 +635,15 @@ void *ggtl_ai_move(GGTL *g)
       case ITERATIVE:
         move = ai_iterative(g, moves);
         break;
+      case PVS:
+        move = ai_pvs(g, moves);
+        break;
+      case MTDF:
+        move = ai_mtdf(g, moves);
+        break;
+      case YBWC:
+        move = ai_ybwc(g, moves);
+        break;
       default:
         fputs("Illegal AI type. How the heck did you manage that?\n", stderr);
         exit(EXIT_FAILURE);
@@ -370,6 +654,8 @@ void *ggtl_ai_move(GGTL *g)
     moves = NULL;
     ai_trace(g, 1, "only one move possible (skipping search)");
   }
+  g->aborted = 0;
+  move = arena_stop(g, move);
 
   state = NULL;
   if (move) {
@@ -382,13 +668,412 @@ void *ggtl_ai_move(GGTL *g)
   return state ? state->data : NULL;
 }
 
+/* Make the move found by pondering, if the opponent made the move
+ * pondered on. Pondering is ended. Returns the new state, or NULL
+ * if there was no ponder hit or no move was found. */
+static void *ponder_result(GGTL *g)
+{
+  GGTL *f = g->ponder;
+  GGTL_VTAB *v = ggtl_vtab(g);
+  GGTL_MOVE *moves, *m;
+  GGTL_STATE *state = NULL;
+  unsigned long key;
+
+  if (!f->ponder_hit) {
+    ggtl_ponder_stop(g);
+    return NULL;
+  }
+  smp_async_join(f);
+
+  /* the fork has made the predicted move and then its own, unless
+   * the game was over */
+  if (sl_count(f->moves) == 2) {
+    key = v->hash(ggtl_peek_state(f), f);
+    moves = ggtl_get_moves(g);
+    while (!state && (m = sl_pop(&moves))) {
+      if (ggtl_move_internal(g, m)) {
+        if (v->hash(ggtl_peek_state(g), g) == key) {
+          state = g->states;
+          break;
+        }
+        m = ggtl_undo_internal(g);
+      }
+      ggtl_cache_moves(g, m);
+    }
+    ggtl_cache_moves(g, moves);
+  }
+
+  if (state) {
+    static const int keys[] = {
+      OVERSHOOT, PLY_REACHED, SCORE, NPS
+    };
+    unsigned i;
+
+    for (i = VISITED; i < GET_KEYS; i++) {
+      g->opts[i] = 0;
+    }
+    for (i = 0; i < sizeof keys / sizeof keys[0]; i++) {
+      g->opts[keys[i]] = f->opts[keys[i]];
+    }
+    g->tt_age = f->tt_age;
+    if (f->tt == g->tt) {
+      f->tt = NULL;
+    }
+    g->ponder = NULL;
+    g->ponder_move = NULL;
+    ggtl_join(g, f);
+  }
+  else {
+    ggtl_ponder_stop(g);
+  }
+  return state ? state->data : NULL;
+}
+
+/* ai_move(), picking up the result of pondering if there is one.
+ * A ggtl_stop() is forgotten once the search is over, not when it
+ * starts, so that one made just as it starts is not lost. */
+static void *think(GGTL *g)
+{
+  void *state = g->ponder ? ponder_result(g) : NULL;
+  if (!state) {
+    state = ai_move(g);
+  }
+  g->halt = 0;
+  return state;
+}
+
+void *ggtl_ai_move(GGTL *g)
+{
+  return think(g);
+}
+
+/*
+
+=item int ggtl_ai_move_start( *g, void (*done)(GGTL *, void *, void *), void *data )
+
+Like C<ggtl_ai_move()>, but the search is made by a thread of its
+own, and this function returns at once. When the move has been
+made, C<done> (if not NULL) is called from that thread with C<g>,
+the new state (or NULL on error) and C<data>; the move made can be
+had from C<ggtl_peek_move()>, as can be done after
+C<ggtl_ai_move()>, and what that says about packed moves goes for
+it too. Until then C<g> must
+not be used except through C<ggtl_ai_move_poll()> and
+C<ggtl_stop()>. Returns 1 if the search was started, or 0 on error
+or if a search started earlier has not been finished.
+
+If GGTL is built without POSIX threads, the search is made before
+this function returns.
+
+=cut
+
+*/
+
+int ggtl_ai_move_start(GGTL *g, void (*done)(GGTL *, void *, void *), 
+                       void *data)
+{
+  assert(g != NULL);
+  if (!smp_async_done(g)) {
+    return 0;
+  }
+  return smp_async(g, think, done, data);
+}
+
+/*
+
+=item int ggtl_ai_move_poll( *g )
+
+Returns 1 if no search started with C<ggtl_ai_move_start()> is
+running (i.e., the move has been made and the callback has
+returned), or 0 if one is.
+
+=cut
+
+*/
+
+int ggtl_ai_move_poll(GGTL *g)
+{
+  return smp_async_done(g);
+}
+
+/*
+
+=item void ggtl_stop( *g )
+
+Ends the search being made for C<g> early. The move made is the
+best one found so far; with the iterative AIs that is normally the
+best move of the last iteration finished. If the search was started
+with C<ggtl_ai_move_start()>, this waits for the move to be made
+and the callback to return. It can also be called from another
+thread while C<ggtl_ai_move()> is running; a call made just as the
+search starts is not lost. So if it is called when no search is
+being made (and none was started with C<ggtl_ai_move_start()>),
+the next C<ggtl_ai_move()> ends at once. Incremental searches (see
+C<ggtl_search_begin()>) are not affected.
+
+=cut
+
+*/
+
+void ggtl_stop(GGTL *g)
+{
+  g->halt = 1;
+  if (g->async) {
+    smp_async_join(g);
+    g->halt = 0;
+  }
+}
+
+/*
+
+=item int ggtl_ponder_start( *g )
+
+Start searching in the background while the opponent thinks
+("pondering"). The opponent's most likely move is guessed (from the
+transposition table if there is one, or else by a one-ply search),
+and a fork of C<g> (see C<ggtl_fork()>) searches the position after
+it. If the next move passed to C<ggtl_move()> is that move (a
+"ponder hit"; it must be a move of the caller's own, e.g. a copy of
+the one returned by C<ggtl_ponder_move()>), the search goes on, and the clock is started. C<ggtl_ai_move()>
+then waits for it and makes the move it found. For the ITERATIVE
+and MTDF AIs the search ends C<TIME> seconds after the hit, even if
+C<HARD_DEADLINE> is not set, and may be several plies deeper than
+it would otherwise have been. For the other AIs the search is the
+same, but may be done by the time C<ggtl_ai_move()> is called.
+
+Any other move, and calling C<ggtl_undo()> or
+C<ggtl_ponder_stop()>, ends pondering and throws away the search.
+If C<g> has a transposition table, it is shared with the fork, so
+what was found while pondering is not all lost.
+
+Pondering requires the C<clone_state()> and C<hash()> callbacks
+(see L<ggtlcb(3)|ggtlcb>), and POSIX threads. Returns 1 if
+pondering was started, 0 otherwise (e.g. if the game is over).
+Until it ends, C<g> must not be used except through
+C<ggtl_move()>, C<ggtl_undo()>, C<ggtl_ai_move()>,
+C<ggtl_ponder_stop()> and C<ggtl_free()>.
+
+=cut
+
+*/
+
+/* Returns a copy of the move of C<m>, the move pondered on, that
+ * lives on when the fork is freed: a packed move is copied as it
+ * is, and others if C<move_size> is set. Otherwise, or if there is
+ * no memory for the copy, the move itself is returned. */
+static void *ponder_copy(GGTL *g, GGTL_MOVE *m)
+{
+  size_t size = m->data == m->packed.c ? sizeof m->packed
+    : (size_t)ggtl_vtab(g)->move_size;
+
+  ggtl_dealloc(g, g->ponder_copy);
+  g->ponder_copy = size > 0 ? ggtl_alloc(g, size) : NULL;
+  if (!g->ponder_copy) {
+    return m->data;
+  }
+  memcpy(g->ponder_copy, m->data, size);
+  return g->ponder_copy;
+}
+
+int ggtl_ponder_start(GGTL *g)
+{
+  GGTL_VTAB *v = ggtl_vtab(g);
+  GGTL *f;
+  int type = ggtl_get(g, TYPE);
+
+  ggtl_ponder_stop(g);
+  if (!v->hash || !smp_async_threaded() || !smp_async_done(g)) {
+    return 0;
+  }
+  f = ggtl_fork_internal(g);
+  if (!f) {
+    return 0;
+  }
+  f->tt = g->tt;
+  if (!ai_predict(f)) {
+    f->tt = NULL;
+    ggtl_free(f);
+    return 0;
+  }
+  g->ponder_key = v->hash(ggtl_peek_state(f), f);
+  g->ponder_move = ponder_copy(g, f->moves);
+  f->pondering = type == ITERATIVE || type == MTDF;
+  f->ponder_hit = 0;
+  if (!smp_async(f, ai_move, NULL, NULL)) {
+    g->ponder_move = NULL;
+    f->tt = NULL;
+    ggtl_free(f);
+    return 0;
+  }
+  g->ponder = f;
+  ai_trace(g, 1, "pondering");
+  return 1;
+}
+
+/*
+
+=item void *ggtl_ponder_move( *g )
+
+Returns the move C<g> is pondering on, or NULL if it is not
+pondering. The move belongs to C<g>, and must not be changed or
+freed, or passed to C<ggtl_move()>; pass a copy of it instead. It
+is a copy of the fork's move if that is packed (see
+C<ggtl_wrap_packed()>) or C<move_size> is set (see
+L<ggtlcb(3)|ggtlcb>), and is then kept until pondering is next
+started or C<g> is freed. Otherwise it is the fork's own move, and
+is only valid until pondering ends.
+
+=cut
+
+*/
+
+void *ggtl_ponder_move(GGTL *g)
+{
+  return g->ponder_move;
+}
+
+/*
+
+=item void ggtl_ponder_stop( *g )
+
+End pondering, if C<g> is, and throw away the search. 
+
+=cut
+
+*/
+
+void ggtl_ponder_stop(GGTL *g)
+{
+  GGTL *f = g->ponder;
+
+  if (f) {
+    g->ponder = NULL;
+    g->ponder_move = NULL;
+    ggtl_stop(f);
+    if (f->tt == g->tt) {
+      f->tt = NULL;
+    }
+    ggtl_free(f);
+  }
+}
+
+/*
+
+=item int ggtl_search_begin( *g )
+
+Start an incremental search for the best move in the current
+position. Rather than searching for C<TIME> seconds like
+C<ggtl_ai_move()>, an incremental search is made a bounded number
+of states at a time by C<ggtl_search_step()>, so a program without
+threads can search in between drawing the board and handling
+input.
+
+The search made is that of the ITERATIVE AI (see
+L<ggtlai(3)|ggtlai>), with the same options, deepened one ply at a
+time up to C<PLY> plies rather than for C<TIME> seconds; the move
+found at each depth is the one ITERATIVE would pick there. It is
+made by one thread, whatever C<THREADS> is set to, and without
+remote workers. A step can end anywhere in the tree, and the next
+one carries on from there, so no work is lost. If the C<hash()>
+callback is provided and C<TT_SIZE> has not been set, a
+transposition table with 65536 entries is allocated. Between
+steps, the current state is that of the game, not one from the
+search.
+
+Returns 1 on success, or 0 on error or if the game is over. Any
+search already begun is ended.
+
+=cut
+
+*/
+
+int ggtl_search_begin(GGTL *g)
+{
+  GGTL_MOVE *moves;
+
+  (void)ai_end(g, 0);
+  ai_reset(g);
+  g->halt = 0;
+  moves = ggtl_get_moves(g);
+  return moves && ai_begin(g, moves);
+}
+
+/*
+
+=item int ggtl_search_step( *g, int max_states )
+
+Carry on the search begun by C<ggtl_search_begin()>, visiting at
+most C<max_states> states (quiescence search included, though one
+begun at the horizon is finished even if that goes over). Returns 1
+if the search is complete, 0 if there is more to do, or -1 on
+error. The counts of states visited and so on (see L<Run-time
+options>) add up over all the steps, and C<PLY_REACHED> and
+C<SCORE> are those of the last complete iteration.
+
+=cut
+
+*/
+
+int ggtl_search_step(GGTL *g, int max_states)
+{
+  assert(g->inc != NULL);
+  assert(max_states > 0);
+  return ai_step(g, max_states);
+}
+
+/*
+
+=item void *ggtl_search_result( *g )
+
+Returns the best move found by the search begun by
+C<ggtl_search_begin()> so far: that of the last complete iteration,
+or the first move generated if no iteration is complete. The move
+belongs to GGTL and must not be changed or freed; if it is packed
+(see C<ggtl_wrap_packed()>) it lives inside GGTL's container, and
+only until the search ends.
+
+=cut
+
+*/
+
+void *ggtl_search_result(GGTL *g)
+{
+  return ai_result(g)->data;
+}
+
+/*
+
+=item void *ggtl_search_end( *g )
+
+Ends the search begun by C<ggtl_search_begin()> and makes the move
+returned by C<ggtl_search_result()>. Returns the new state, or
+NULL on error.
+
+=cut
+
+*/
+
+void *ggtl_search_end(GGTL *g)
+{
+  GGTL_MOVE *m = ai_end(g, 1);
+  GGTL_STATE *state = NULL;
+
+  if (m) {
+    state = ggtl_move_internal(g, m);
+    if (!state) {
+      ggtl_cache_moves(g, m);
+    }
+  }
+  return state ? state->data : NULL;
+}
+
 /*
 
 =item void *ggtl_undo( *g )
 
 Reverts the internal game state to the previous.  Returns a
 pointer to the new current state, or NULL on error (e.g. if there
-was no move to undo).
+was no move to undo). Ends pondering and incremental searches.
 
 =cut
 
@@ -399,6 +1084,8 @@ void *ggtl_undo( GGTL *g )
   GGTL_MOVE *n;
   void *s = NULL;
 
+  ggtl_ponder_stop(g);
+  (void)ai_end(g, 0);
   n = ggtl_undo_internal(g);
   if (n) {
     ggtl_cache_moves(g, n);
@@ -436,7 +1123,9 @@ GGTL_MOVE *ggtl_undo_internal( GGTL *g )
     }
     else {
       GGTL_STATE *ns = sl_pop(&g->states);
-      ggtl_cache_states(g, ns);
+      if (!stack_pop(g, ns)) {
+        ggtl_cache_states(g, ns);
+      }
     }
   }
 
@@ -466,10 +1155,16 @@ those you need C<ggtl_set_float()> and C<ggtl_get_float()>.
 
 Get/set the values of the given keys. In contrast to C<ggtl_set()>
 and C<ggtl_get()>, these functions can be used to set and retrieve
-the TIME parameter, which is a floating point number. Take care,
+the TIME and PROBCUT parameters, which are floating point
+numbers, and the OVERSHOOT parameter in seconds. Take care,
 however, to provide values of the correct type (by casting them if
 necessary), lest bad things will happen.
 
+=item void ggtl_set_string( *g, int key, const char *value )
+
+Sets the C<TT_SHM> option, which is a string. Passing NULL
+unsets it.
+
 The following keys are available:
 
 =over
@@ -482,11 +1177,21 @@ void ggtl_set(GGTL *g, int key, int value)
 {
   assert(key >= 0);
   assert(key < SET_KEYS);
-  assert(key != TIME);
+  assert(key != TIME && key != PROBCUT && key != TT_SHM);
   if (key == MSEC) {
     fputs("Warning: using MSEC is deprecated; use TIME instead.\n", stderr);
     ggtl_set_float(g, TIME, value / 1000.0);
   }
+  else if (key == TT_SIZE) {
+    g->opts[key] = tt_resize(g, value);
+  }
+  else if (key == SEED) {
+    g->opts[key] = value;
+    g->rng = (unsigned long)value & 0xffffffffUL;
+    if (!g->rng) {
+      g->rng = 2463534242UL;  /* xorshift can't start from 0 */
+    }
+  }
   else {
     g->opts[key] = value;
   }
@@ -497,7 +1202,7 @@ int ggtl_get(GGTL *g, int key)
   int value;
   assert(key >= 0);
   assert(key < GET_KEYS);
-  assert(key != TIME);
+  assert(key != TIME && key != PROBCUT);
   if (key == MSEC) {
     fputs("Warning: using MSEC is deprecated; use TIME instead.\n", stderr);
     value = (int)(ggtl_get_float(g, TIME) * 1000);
@@ -510,13 +1215,33 @@ int ggtl_get(GGTL *g, int key)
 
 void ggtl_set_float(GGTL *g, int key, float f)
 {
-  assert(key == TIME);  
-  g->time_to_search = f;
+  assert(key == TIME || key == PROBCUT);
+  if (key == PROBCUT) {
+    g->probcut_t = f;
+  }
+  else {
+    g->time_to_search = f;
+  }
+}
+
+void ggtl_set_string(GGTL *g, int key, const char *value)
+{
+  assert(key == TT_SHM);
+  if (!tt_share(g, value)) {
+    return;
+  }
+  g->opts[TT_SIZE] = tt_resize(g, g->opts[TT_SIZE]);
 }
 
 float ggtl_get_float(GGTL *g, int key)
 {
-  assert(key == TIME);
+  assert(key == TIME || key == PROBCUT || key == OVERSHOOT);
+  if (key == OVERSHOOT) {
+    return g->opts[OVERSHOOT] / 1000000.0;
+  }
+  if (key == PROBCUT) {
+    return g->probcut_t;
+  }
   return g->time_to_search;
 }
 
@@ -546,9 +1271,9 @@ The depth to search to for the fixed-depth AI.
 =item TRACE (int)
 
 The level of trace information to print during search. The trace
-information will be printed to standard output. Zero (the
-default) turns off tracing; larger numbers give more detailed
-trace output.
+information will be printed to standard output, or wherever
+C<ggtl_set_trace()> says. Zero (the default) turns off tracing;
+larger numbers give more detailed trace output.
 
 =item CACHE (int)
 
@@ -561,6 +1286,184 @@ valid values are combinations of the following, ORed together:
 Example: use C<ggtl_set(g, CACHE, STATES | MOVES)> to cache both
 moves and states (this is the default).
 
+=item TT_SIZE (int)
+
+The number of entries in the transposition table used by the
+Alpha-Beta based AIs. Setting it (re)allocates the table, and
+clears it. Zero (the default) disables the table. The table is
+only used if the C<hash()> callback is provided; see
+L<ggtlcb(3)|ggtlcb>.
+
+When getting, returns the current size; this is 0 if allocating
+the table failed.
+
+=item TT_SHM (string)
+
+The name of a POSIX shared-memory segment (such as
+C</reversi-tt>) to keep the transposition table in, so that all
+the processes on a machine using the same name share their search
+results. It can only be set with C<ggtl_set_string()>, and should
+be set before C<TT_SIZE>. The segment is created with room for
+C<TT_SIZE> entries if it does not exist; if it does, every
+process must use the same C<TT_SIZE>, or setting it fails. The
+table is not cleared when a process joins, and the segment is
+left for the next process when the last one leaves: remove it
+with C<shm_unlink()>.
+
+Entries are stored and read without locking, in the same way as
+by helper threads (see C<THREADS>), and entries stored by other
+processes' searches are replaced as freely as those from earlier
+searches. The processes must run the same program, as the entries
+are stored as they are laid out in memory. Forks (see
+C<ggtl_fork()>) share the segment too; a process started with
+fork() after the segment was set should set it again, so that its
+entries are told apart from those of its parent.
+
+When getting with C<ggtl_get()>, returns 1 if the table is in a
+shared-memory segment, 0 otherwise.
+
+=item ASPIRATION (int)
+
+The width of the aspiration window on either side of the previous
+iteration's score used by the iterative AI. Zero (the default)
+searches every iteration with the full window. See
+L<ggtlai(3)|ggtlai>.
+
+=item ASP_GROWTH (int)
+
+How many times wider to make the aspiration window when a search
+falls outside it. The default is 4. Values below 2 make the
+window fully open straight away.
+
+=item HARD_DEADLINE (int)
+
+If true, the iterative AI aborts its search when the time set
+with C<TIME> is up, rather than finishing the iteration it is in.
+The default is false. See L<ggtlai(3)|ggtlai>.
+
+=item POLL (int)
+
+The number of states visited between each time the clock is
+checked when C<HARD_DEADLINE> is set. Lower values make the
+search stop closer to the deadline, at the cost of reading the
+clock more often. The default is 1000.
+
+=item KILLERS (int)
+
+=item HISTORY (int)
+
+If true, the Alpha-Beta based AIs use the killer move and history
+heuristics, respectively, to decide which order to search moves
+in. Moves that caused a cutoff in a sibling position (killers),
+or that have caused cutoffs anywhere in the tree (history), are
+searched first. Both are off by default, and require the
+C<move_key()> callback; see L<ggtlcb(3)|ggtlcb>.
+
+=item QS_DEPTH (int)
+
+=item QS_NODES (int)
+
+The maximum depth of the quiescence search carried out at the
+end of Alpha-Beta searches if the C<get_noisy_moves()> callback is
+provided, and the maximum number of states it may visit during a
+search. The defaults are 8 and 0 (no limit). Setting C<QS_DEPTH>
+to 0 turns off quiescence search.
+
+=item NULL_MOVE (int)
+
+If non-zero, the Alpha-Beta AIs use null-move pruning: before
+searching the moves at a position, the player to move passes, and
+the position is searched with a null window, this many plies
+shallower than usual. If the player is still better off than
+beta, the position is cut off. 2 or 3 are typical values. The
+default is 0 (off). This requires the C<null_move()> and
+C<null_unmove()> callbacks; see L<ggtlcb(3)|ggtlcb>.
+
+Null-move pruning is only safe for games where passing is never
+better than making a move.
+
+=item LMR (int)
+
+=item LMR_DEPTH (int)
+
+If C<LMR> is non-zero, late move reductions are used: at positions
+with more than C<LMR_DEPTH> plies left to search, moves after the
+first C<LMR> moves are searched one ply shallower with a null
+window first, and only searched in full if that shows they might
+be better than the best so far. This works best when moves are
+searched in a good order; see C<KILLERS> and C<HISTORY>. The
+defaults are 0 (off) and 2.
+
+=item FUTILITY (int)
+
+=item FUTILITY_DEPTH (int)
+
+If C<FUTILITY> is non-zero, futility pruning is used: at positions
+with C<FUTILITY_DEPTH> or fewer plies left to search, only the
+first move is searched if the evaluation of the position is so
+low that gaining C<FUTILITY> for each ply left would not make it
+better than alpha. The defaults are 0 (off) and 1.
+
+=item PROBCUT (float)
+
+If non-zero, the Alpha-Beta AIs use ProbCut: at positions with a
+depth left to search for which parameters have been loaded with
+C<ggtl_probcut_load()>, a shallow search is used to predict the
+score of the deep one. If the prediction is more than this many
+standard deviations above beta (or below alpha) the position is
+cut off without the deep search. 1.5 is a typical value. The
+default is 0 (off). This option is only available through
+C<ggtl_set_float()> and C<ggtl_get_float()>.
+
+=item THREADS (int)
+
+The number of threads the ITERATIVE, MTDF and YBWC AIs search
+with. The default is 1. The extra threads require the
+C<clone_state()> callback. For ITERATIVE and MTDF they search the
+same position as the main thread, and share what they find through
+the transposition table, so they also require the C<hash()>
+callback and C<TT_SIZE> to be set. See L<ggtlai(3)|ggtlai>.
+
+=item ROOT_PARALLEL (int)
+
+If true, and C<THREADS> is above 1, the FIXED and ITERATIVE AIs
+share out the moves at the root among the threads, each searching
+with a fork of C<g> (see C<ggtl_fork()>). The threads share the
+best score found so far. The move picked is the same as with one
+thread. C<VISITED> and the other counts include the work of all
+the threads. The default is false.
+
+=item SEED (int)
+
+Seeds the random number generator used by the RANDOM AI. Each
+GGTL structure has its own generator, so instances in different
+threads do not disturb each other, and the same seed always gives
+the same moves. Setting it restarts the generator. The default is
+1; set it to something like C<time(NULL)> to get different moves
+every run.
+
+=item ARENA (int)
+
+If set, C<ggtl_ai_move()> takes the C<GGTL_STATE> and C<GGTL_MOVE>
+nodes it can't get from the cache (see L<Interaction with GGTL's
+cache of states and moves>) from slabs, handed out in turn, rather
+than calling L<malloc(3)|malloc> for each one. The first slab has
+room for this many nodes, and each one after that for twice as
+many as the last. During the search the nodes go round the cache
+like other nodes. When it is over, the move made is copied out of
+the arena, and every slab but the first whose nodes are all unused
+is freed; if all the nodes of the newest slab left are unused, it
+is handed out from the start again. So after a move the arena
+holds the first slab and the slabs of nodes still in the cache:
+without the cache, just the first slab. The rest is freed by
+C<ggtl_free()>. The default is 0 (off). The arena is not used if
+C<THREADS> is above 1.
+
+Nodes from the arena can turn up in moves returned by
+C<ggtl_get_moves()> and in the cache, whatever this option is set
+to later on. Give them back with C<ggtl_cache_moves()> and
+C<ggtl_cache_states()>; never free them yourself.
+
 =item VISITED (int) - (getting only)
 
 Returns the number of states visited by the last AI search, or -1
@@ -572,6 +1475,75 @@ value is undefined.
 Returns the effective depth of the last iterative AI search. The
 value is undefined if no such search has taken place.
 
+=item TT_HITS (int) - (getting only)
+
+=item TT_MISSES (int) - (getting only)
+
+Returns the number of transposition table lookups during the last
+AI search that found, or failed to find, an entry for the
+position.
+
+=item OVERSHOOT (int) - (getting only)
+
+Returns how many microseconds the last iterative AI search went
+past the time set with C<TIME>, or 0 if it finished in time. Use
+C<ggtl_get_float()> to get the value in seconds.
+
+=item CUTOFFS (int) - (getting only)
+
+=item FIRST_CUTOFFS (int) - (getting only)
+
+Returns the number of cutoffs during the last AI search, and how
+many of those were caused by the first move searched at the
+position. The closer they are, the better the move ordering.
+
+=item QS_VISITED (int) - (getting only)
+
+Returns the number of states visited by the quiescence search
+during the last AI search. These are not included in C<VISITED>.
+
+=item NULL_CUTOFFS (int) - (getting only)
+
+=item LMR_REDUCED (int) - (getting only)
+
+=item FUTILITY_PRUNED (int) - (getting only)
+
+Returns the number of cutoffs by null-move pruning, of moves
+searched with reduced depth by late move reductions, and of moves
+skipped by futility pruning, during the last AI search.
+
+=item SCORE (int) - (getting only)
+
+Returns the score of the move picked by the last FIXED, PVS,
+ITERATIVE or MTDF search, from the point of view of the player
+that made it. The value is undefined if no such search has taken
+place.
+
+=item PROBCUT_CUTS (int) - (getting only)
+
+Returns the number of positions cut off by ProbCut during the
+last AI search.
+
+=item NPS (int) - (getting only)
+
+Returns the number of states visited per second (including those
+visited by the quiescence search) by the last ITERATIVE or MTDF
+search, or 0 if there was no such search. Helper threads are not
+included; see C<ggtl_get_thread()>.
+
+=item TT_SHARED_HITS (int) - (getting only)
+
+Returns how many of the C<TT_HITS> of the last AI search found an
+entry stored by another process sharing the table (see
+C<TT_SHM>). Divided by C<TT_HITS> plus C<TT_MISSES>, this is the
+rate at which processes reuse each other's work.
+
+=item MALLOCS (int) - (getting only)
+
+Returns the number of blocks allocated (see C<ggtl_alloc()>) by the
+last C<ggtl_ai_move()>, for nodes (and slabs of them, see C<ARENA>)
+and the search itself, and by callbacks using C<ggtl_alloc()>.
+
 =back
 
 =cut
@@ -583,14 +1555,255 @@ void ai_trace(GGTL *g, int depth, char *fmt, ...)
 {
   va_list ap;
   if (ggtl_get(g, TRACE) >= depth) {
-    fprintf(stdout, "%*s", depth - 1, "");
+    fprintf(g->trace, "%*s", depth - 1, "");
     va_start(ap, fmt);
-    (void)vfprintf(stdout, fmt, ap);
+    (void)vfprintf(g->trace, fmt, ap);
     va_end(ap);
-    fputc('\n', stdout);
+    fputc('\n', g->trace);
   }
 }
+
+/* Returns a random number from 0 to n-1, from the generator of
+ * C<g> (Marsaglia's 32-bit xorshift). */
+int ai_rand(GGTL *g, int n)
+{
+  unsigned long x = g->rng;
+
+  assert(n > 0);
+  x ^= (x << 13) & 0xffffffffUL;
+  x ^= x >> 17;
+  x ^= (x << 5) & 0xffffffffUL;
+  g->rng = x;
+  return (int)(x % (unsigned long)n);
+}
   
+/*
+
+=item int ggtl_probcut_load( *g, const char *path )
+
+Load ProbCut parameters from the file at C<path>. Each line of the
+file holds five numbers: the depth the parameters are for, the
+depth of the shallow search used to predict the score at that
+depth, and the slope, intercept and standard deviation of the
+error of the linear prediction. Empty lines and lines starting
+with C<#> are ignored. Depths must be below 32.
+
+Such files can be made with the C<reversi-probcut> program for
+Reversi, which also shows how to make them for other games.
+Parameters loaded replace any previously loaded for the same
+depths. Set the C<PROBCUT> option to use them.
+
+Returns the number of depths parameters were loaded for, or -1 if
+the file could not be read or is malformed.
+
+=cut
+
+*/
+
+int ggtl_probcut_load(GGTL *g, const char *path)
+{
+  FILE *fp;
+  char line[256];
+  int count = 0;
+
+  fp = fopen(path, "r");
+  if (!fp) {
+    return -1;
+  }
+
+  while (count >= 0 && fgets(line, sizeof line, fp)) {
+    struct ggtl_probcut p;
+    int deep, n;
+    char *s = line + strspn(line, " \t\r\n");
+
+    if (!*s || *s == '#') {
+      continue;
+    }
+    n = sscanf(s, "%d %d %f %f %f", &deep, &p.shallow, &p.a, &p.b,
+      &p.sigma);
+    if (n != 5 || deep < 1 || deep >= PROBCUT_DEPTHS || p.shallow < 0
+        || p.shallow >= deep || p.a <= 0 || p.sigma < 0) {
+      count = -1;
+    }
+    else {
+      g->probcut[deep] = p;
+      count++;
+    }
+  }
+
+  fclose(fp);
+  return count;
+}
+
+/*
+
+=item int ggtl_get_thread( *g, int thread, int key )
+
+Like C<ggtl_get()> for the getting-only keys, but returns the
+value for one of the threads that took part in the last search
+(see C<THREADS>). Thread 0 is the one that called
+C<ggtl_ai_move()>, and gives the same values as C<ggtl_get()>
+(which, for the YBWC AI and C<ROOT_PARALLEL>, includes the work of
+the other threads).
+Returns -1 if there was no such thread.
+
+=cut
+
+*/
+
+int ggtl_get_thread(GGTL *g, int thread, int key)
+{
+  assert(key >= SET_KEYS);
+  assert(key < GET_KEYS);
+  return smp_get(g, thread, key);
+}
+
+/*
+
+=item void ggtl_set_trace( *g, FILE *fp )
+
+Send the trace output of C<g> (see C<TRACE>) to C<fp> instead of
+standard output. Passing NULL restores standard output. A fork of
+C<g> traces to the same place.
+
+=cut
+
+*/
+
+void ggtl_set_trace(GGTL *g, FILE *fp)
+{
+  g->trace = fp ? fp : stdout;
+}
+
+/*
+
+=item void ggtl_set_allocator( *g, void *(*alloc)(size_t, void *), void (*dealloc)(void *, void *), void *ctx )
+
+Make C<g> allocate memory with C<alloc(size, ctx)> and free it with
+C<dealloc(block, ctx)> instead of L<malloc(3)|malloc> and
+L<free(3)|free>. This goes for the nodes wrapping states and moves,
+the transposition table (unless it is in shared memory, see
+C<TT_SHM>), move ordering tables and the buffers used by searches,
+and for the states and moves made by the Reversi and Nim extensions
+(see C<ggtl_alloc()> below). Passing NULL for C<alloc> restores
+malloc() and free().
+
+Memory is freed with the allocator set when it is freed, so set it
+right after C<ggtl_new()>, before C<g> allocates anything, and
+don't change it afterwards. The states and moves you give C<g>
+(with C<ggtl_init()> and C<ggtl_move()>) are also freed with it,
+by the C<release_state()> and C<release_move()> callbacks of the
+extensions; allocate them with C<ggtl_alloc()> (or e.g.
+C<reversi_state_clone()>) if it can't free memory from malloc().
+
+Forks of C<g> (and so helper threads, see C<THREADS>) use the same
+allocator, which must then be safe to call from several threads at
+once. The C<GGTL> structure itself is always allocated with
+malloc().
+
+=item void *ggtl_alloc( *g, size_t size )
+
+Returns C<size> bytes allocated with the allocator of C<g>, or
+with malloc() if C<g> is NULL; or NULL on error. Callbacks can use
+this for the states and moves they make. The allocation is counted
+by C<MALLOCS>.
+
+=item void ggtl_dealloc( *g, void *block )
+
+Frees memory returned by C<ggtl_alloc()> for the same C<g>. Does
+nothing if C<block> is NULL. With the default allocator, or if
+C<g> is NULL, this is the same as free().
+
+=cut
+
+*/
+
+static void *std_alloc(size_t size, void *ctx)
+{
+  (void)ctx;
+  return malloc(size);
+}
+
+static void std_dealloc(void *block, void *ctx)
+{
+  (void)ctx;
+  free(block);
+}
+
+void ggtl_set_allocator(GGTL *g, void *(*alloc)(size_t, void *),
+                        void (*dealloc)(void *, void *), void *ctx)
+{
+  if (!alloc || !dealloc) {
+    alloc = &std_alloc;
+    dealloc = &std_dealloc;
+    ctx = NULL;
+  }
+  g->alloc = alloc;
+  g->dealloc = dealloc;
+  g->alloc_ctx = ctx;
+}
+
+void *ggtl_alloc(GGTL *g, size_t size)
+{
+  void *p;
+
+  if (!g) {
+    return malloc(size);
+  }
+  p = g->alloc(size, g->alloc_ctx);
+  if (p) {
+    g->opts[MALLOCS]++;
+  }
+  return p;
+}
+
+void ggtl_dealloc(GGTL *g, void *block)
+{
+  if (!block) {
+    return;
+  }
+  if (g) {
+    g->dealloc(block, g->alloc_ctx);
+  }
+  else {
+    free(block);
+  }
+}
+
+/* Frees C<state>, with the release_state() callback if there is one */
+void state_release(GGTL *g, void *state)
+{
+  if (g->vtab->release_state) {
+    g->vtab->release_state(state, g);
+  }
+  else {
+    g->vtab->free_state(state);
+  }
+}
+
+/* Like state_release(), for moves */
+void move_release(GGTL *g, void *move)
+{
+  if (g->vtab->release_move) {
+    g->vtab->release_move(move, g);
+  }
+  else {
+    g->vtab->free_move(move);
+  }
+}
+
+/* Like realloc(), for memory from ggtl_alloc() of C<old> bytes */
+void *mem_realloc(GGTL *g, void *block, size_t old, size_t size)
+{
+  void *p = ggtl_alloc(g, size);
+
+  if (p && block) {
+    memcpy(p, block, old < size ? old : size);
+    ggtl_dealloc(g, block);
+  }
+  return p;
+}
+
 
 /*
 
@@ -618,6 +1831,10 @@ void *ggtl_peek_state( GGTL *g )
 =item void *ggtl_peek_move( *g )
 
 Returns a pointer to the last move performed, or NULL on error.
+The move belongs to GGTL. If it is packed (see
+C<ggtl_wrap_packed()>) it lives inside GGTL's container, and only
+until the move is undone: it can't be freed or passed to
+C<ggtl_move()>, so copy it if you need one of your own.
 
 =cut
 
@@ -711,7 +1928,7 @@ GGTL_STATE *ggtl_sc_new(void *data)
 {
   GGTL_STATE *n;
 
-  n = malloc(sizeof *n);
+  n = ggtl_alloc(NULL, sizeof *n);
   if (n) {
     n->next = NULL;
     n->data = data;
@@ -725,9 +1942,15 @@ GGTL_STATE *ggtl_wrap_state(GGTL *g, void *data)
   GGTL_STATE *n = sl_pop(&g->sc_cache);
 
   if (!n) {
-    n = ggtl_sc_new(data);
+    n = arena_node(g);
   }
-  else {
+  if (!n) {
+    n = ggtl_alloc(g, sizeof *n);
+    if (n) {
+      n->next = NULL;
+    }
+  }
+  if (n) {
     n->data = data;
   }
 
@@ -749,7 +1972,7 @@ GGTL_MOVE *ggtl_mc_new(void *data)
 {
   GGTL_MOVE *n;
 
-  n = malloc(sizeof *n);
+  n = ggtl_alloc(NULL, sizeof *n);
   if (n) {
     n->next = NULL;
     n->fitness = 0;
@@ -764,15 +1987,67 @@ GGTL_MOVE *ggtl_wrap_move(GGTL *g, void *data)
   GGTL_MOVE *n = sl_pop(&g->mc_cache);
 
   if (!n) {
-    n = ggtl_mc_new(data);
+    n = arena_node(g);
   }
-  else {
+  if (!n) {
+    n = ggtl_alloc(g, sizeof *n);
+    if (n) {
+      n->next = NULL;
+      n->fitness = 0;
+    }
+  }
+  if (n) {
     n->data = data;
   }
 
   return n;
 }
 
+/*
+
+=item GGTL_MOVE *ggtl_wrap_packed( *g )
+
+Returns a C<GGTL_MOVE> container with the move packed into it, or
+NULL if an error occurs. Its C<data> member points to the
+C<GGTL_PACKED_SIZE> (8) bytes of its C<packed> member, which you
+fill in with the move: a structure that small (e.g. a pair of
+C<int> coordinates), or an integer in C<packed.i>. Such moves need
+no allocation of their own and are never passed to the
+C<release_move()> or C<free_move()> callbacks, and a list of them
+can be freed just by freeing the containers.
+
+A packed move only lives as long as its container, so don't keep
+pointers to it after the container is cached, and don't pass it to
+C<ggtl_move()> or C<ggtl_wrap_move()>. This goes for packed moves
+that GGTL hands back too: those returned by C<ggtl_peek_move()> and
+C<ggtl_search_result()> are inside GGTL's containers, and can't be
+freed or passed to C<ggtl_move()>; make a copy of your own.
+C<ggtl_ponder_move()> returns a copy kept by GGTL, which must not be
+freed either. A container is taken from
+the move cache if there is one there, and the move in it freed if
+it is not packed.
+
+=cut
+
+*/
+
+GGTL_MOVE *ggtl_wrap_packed(GGTL *g)
+{
+  GGTL_MOVE *n = ggtl_uncache_move(g);
+
+  if (n && n->data && n->data != n->packed.c) {
+    move_release(g, n->data);
+  }
+  if (!n) {
+    n = ggtl_wrap_move(g, NULL);
+  }
+  if (n) {
+    n->data = n->packed.c;
+  }
+
+  return n;
+}
+
 
 /*
 
@@ -858,6 +2133,9 @@ Retrieve a state or a move from its respective cache. The
 C<ggtl_uncache_*_raw> versions drops the wrapper node and returns
 pointers to the actual state/move.
 
+Packed moves (see C<ggtl_wrap_packed()>) can't be had without
+their node, so C<ggtl_uncache_move_raw()> passes over them.
+
 =cut
 
 */
@@ -889,10 +2167,12 @@ void *ggtl_uncache_state_raw(GGTL *g)
 void *ggtl_uncache_move_raw(GGTL *g)
 {
   void *move = NULL;
-  GGTL_MOVE *node = ggtl_uncache_move(g);
+  GGTL_MOVE *node;
 
-  if (node) {
-    move = node->data;
+  while (!move && (node = ggtl_uncache_move(g))) {
+    if (node->data != node->packed.c) {
+      move = node->data;
+    }
     node->data = NULL;
     g->mc_cache = sl_push(g->mc_cache, node);
   }
@@ -917,22 +2197,31 @@ void ggtl_cache_free(GGTL *g)
   move_cache_free(g);
 }
 
+/* Nodes of the arena are not freed, but kept as spares (see ARENA) */
 static void state_cache_free(GGTL *g)
 {
   void *n;
   while ((n = ggtl_uncache_state_raw(g))) {
-    g->vtab->free_state(n);
+    state_release(g, n);
+  }
+  while ((n = sl_pop(&g->sc_cache))) {
+    if (!arena_spare(g, n)) {
+      ggtl_dealloc(g, n);
+    }
   }
-  sl_free(g->sc_cache, NULL);
 }
 
 static void move_cache_free(GGTL *g)
 {
   void *n;
   while ((n = ggtl_uncache_move_raw(g))) {
-    g->vtab->free_move(n);
+    move_release(g, n);
+  }
+  while ((n = sl_pop(&g->mc_cache))) {
+    if (!arena_spare(g, n)) {
+      ggtl_dealloc(g, n);
+    }
   }
-  sl_free(g->mc_cache, NULL);
 }
 
 /*
@@ -957,6 +2246,10 @@ game using GGTL.
 See L<ggtlai(3)|ggtlai> for the various AIs supported by
 C<ggtl_ai_move()>. 
 
+L<ggtlpool(3)|ggtlpool> describes how to share a few threads among
+many GGTL structures, and L<ggtlnet(3)|ggtlnet> how to share a
+search among several processes.
+
 L<ggtlcb(3)|ggtlcb> documents the callback functions required by
 GGTL to support game-tree search for a whole range of games.
 
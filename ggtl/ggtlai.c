@@ -28,9 +28,25 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #include "core.h"
 #include "private.h"
 
-static int ab(GGTL *g, int alpha, int beta, int ply);
+static int pvs(GGTL *g, int alpha, int beta, int plytogo, int searched);
+static int search_move(GGTL *g, int alpha, int beta, int plytogo,
+                       int searched);
 
-#if HAVE_GETTIMEOFDAY
+/* deepest iteration made while pondering, before the opponent has
+ * moved */
+#define PONDER_PLIES 64
+
+#include <time.h>
+
+#if HAVE_CLOCK_GETTIME && defined(CLOCK_MONOTONIC)
+
+static double setstarttime() {
+  struct timespec t;
+  (void)clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + (t.tv_nsec / 1000000000.0);
+}
+
+#elif HAVE_GETTIMEOFDAY
 
 #if HAVE_SYS_TIME_H
 #include <sys/time.h>
@@ -44,19 +60,70 @@ static double setstarttime() {
 
 #else
 
-#include <time.h>
 static double setstarttime() {
   return clock() / (double)CLOCKS_PER_SEC;
 }
 
 #endif
 
+/* The clock used for TIME, for the other modules. */
+double ai_clock(void)
+{
+  return setstarttime();
+}
+
 static int havetimeleft(double start, double max)
 {
   double elapsed = setstarttime() - start;
   return elapsed < max;
 }
 
+/* Returns true if ggtl_stop() has been called for C<g>, or for the
+ * instance it is helping. */
+static int halted(GGTL *g)
+{
+  return g->halt || (g->master && g->master->halt);
+}
+
+/* While pondering the clock does not run. Once the opponent has
+ * made the move pondered on, it is started, and the search ends at
+ * the deadline. Returns true if the clock is running. */
+static int ponder_hit(GGTL *g)
+{
+  if (g->pondering && g->ponder_hit) {
+    g->pondering = 0;
+    g->started = setstarttime();
+    g->deadline = g->started + g->time_to_search;
+    ai_trace(g, 1, "ponder hit");
+  }
+  return !g->pondering;
+}
+
+/* Check the clock every POLL states visited, and abort the search
+ * if the deadline has passed, if ggtl_stop() has been called, or if
+ * this is a helper thread and it has been told to stop. Returns
+ * true if the search has been aborted. */
+static int timeout(GGTL *g)
+{
+  int poll = ggtl_get(g, POLL);
+
+  /* incremental searches are only ended by their step's limit,
+   * which ab() checks */
+  if ((g->stop && *g->stop) || (!g->inc && halted(g))) {
+    g->aborted = 1;
+  }
+  if (g->pondering) {
+    (void)ponder_hit(g);
+  }
+  if (g->deadline > 0 && !g->aborted
+      && (poll < 2 || (g->opts[VISITED] + g->opts[QS_VISITED]) % poll == 0)
+      && setstarttime() >= g->deadline) {
+    ai_trace(g, 1, "deadline passed; aborting search");
+    g->aborted = 1;
+  }
+  return g->aborted;
+}
+
 #if 0 /* C comments don't nest */
 
 =head1 NAME
@@ -113,9 +180,8 @@ GGTL_MOVE *ai_none(GGTL *g, GGTL_MOVE *moves)
 =item RANDOM
 
 Not really an AI either. Picks one of the available moves at
-random. It is the responsibility of the user to call srand() to
-make sure the random generator is seeded differently for each
-run.
+random, using a generator private to the GGTL structure. Set the
+C<SEED> key to get different moves for each run.
 
 =cut
 
@@ -128,7 +194,7 @@ GGTL_MOVE *ai_random(GGTL *g, GGTL_MOVE *moves)
   
   assert(1 < sl_count(moves));
 
-  idx = rand() % sl_count(moves);
+  idx = ai_rand(g, sl_count(moves));
   while (idx--) {
     ggtl_cache_moves(g, sl_pop(&moves));
   }
@@ -148,6 +214,36 @@ Performs a fixed-depth Alpha-Beta search to find the best move at
 a given ply (depth in the game tree). The depth to be searched
 can be set with C<ggtl_set(g, PLY, depth)>.
 
+If the C<hash()> callback is provided and C<TT_SIZE> is set, the
+search stores its results in a transposition table. Positions that
+are reached again through a different order of moves are then
+not searched again, and the best move found for a position
+earlier is tried first when it has to be.
+
+With the C<KILLERS> and C<HISTORY> options set, moves that caused
+cutoffs elsewhere in the tree are searched before other moves.
+Like a transposition table, these make cutoffs happen sooner, so
+that fewer states are visited; the move picked is the same.
+
+If the C<get_noisy_moves()> callback is provided, the positions at
+the end of the search are not evaluated straight away if there
+are noisy moves (such as captures) available. A quiescence search
+of just those moves is carried out first, to avoid evaluating
+positions in the middle of an exchange. See C<QS_DEPTH> and
+C<QS_NODES> in L<ggtl(3)|ggtl>.
+
+The search can be made selective, to reach deeper in the same
+time, with the C<NULL_MOVE>, C<LMR> and C<FUTILITY> options (see
+L<ggtl(3)|ggtl>). These prune or reduce the search of moves that
+are unlikely to matter. Unlike the options above they can change
+the move picked, hopefully for the better. They are all off by
+default.
+
+The C<PROBCUT> option works the same way, but relies on
+statistics of how well shallow searches predict deeper ones for
+the game being played. See C<ggtl_probcut_load()> in
+L<ggtl(3)|ggtl>.
+
 =cut
 
 */
@@ -156,30 +252,54 @@ int fitness_cmp(void *anode, void *bnode)
 {
   GGTL_MOVE *a = anode;
   GGTL_MOVE *b = bnode;
-  return b->fitness - a->fitness;
+  return a->fitness > b->fitness ? -1 : a->fitness < b->fitness;
+}
+
+/* Number the moves in the order get_moves() returned them, so
+ * that the best one can be remembered in the transposition table.
+ * Moves the one with index C<first> (if any) to the front. */
+static GGTL_MOVE *number_moves(GGTL_MOVE *moves, int first)
+{
+  GGTL_MOVE *m, *prev;
+  int i;
+
+  for (i = 0, m = moves; m; m = m->next) {
+    m->fitness = i++;
+  }
+
+  for (prev = NULL, m = moves; first > 0 && m; prev = m, m = m->next) {
+    if (m->fitness == first) {
+      prev->next = m->next;
+      m->next = moves;
+      return m;
+    }
+  }
+  return moves;
 }
 
-static int ab(GGTL *g, int alpha, int beta, int plytogo)
+/* Quiescence search: only noisy moves are searched, until the
+ * position is quiet or QS_DEPTH plies have been searched. The side
+ * to move can choose to stand pat on the static evaluation rather
+ * than play any of them. States visited are counted in QS_VISITED,
+ * and no more than QS_NODES (if set) are visited in a search. */
+static int quiesce(GGTL *g, int alpha, int beta, int depth)
 {
   GGTL_MOVE *moves, *m;
-  int tracelevel = ggtl_get(g, PLY) - plytogo + 2;
+  GGTL_VTAB *v = ggtl_vtab(g);
+  int stand, limit = ggtl_get(g, QS_NODES);
 
-  g->opts[VISITED]++;
-  
-  moves = ggtl_get_moves(g);
-  if (!moves || plytogo <= 0) {
-    int fitness;
-    if (!moves) { g->saw_end = 1; }
-    else { ggtl_cache_moves(g, moves); }
-    fitness = ggtl_vtab(g)->eval(ggtl_peek_state(g), g);
-    ai_trace(g, tracelevel, "%s: %d", 
-      moves ? "ply limit" : "leaf state", fitness);
-    return fitness;
+  stand = v->eval(ggtl_peek_state(g), g);
+  if (stand > alpha) {
+    alpha = stand;
   }
-  
-  while (alpha < beta && (m = sl_pop(&moves))) {
+  if (alpha >= beta || depth >= ggtl_get(g, QS_DEPTH)) {
+    return alpha;
+  }
+
+  moves = v->get_noisy_moves(ggtl_peek_state(g), g);
+  while (alpha < beta && (!limit || g->opts[QS_VISITED] < limit)
+         && (m = sl_pop(&moves))) {
     int sc;
-    void *state;
 
     if (!ggtl_move_internal(g, m)) {
       ggtl_cache_moves(g, m);
@@ -187,129 +307,2004 @@ static int ab(GGTL *g, int alpha, int beta, int plytogo)
       break;
     }
 
-    sc = -ab(g, -beta, -alpha, plytogo - 1);
+    g->opts[QS_VISITED]++;
+    sc = timeout(g) ? 0 : -quiesce(g, -beta, -alpha, depth + 1);
+    ggtl_cache_moves(g, ggtl_undo_internal(g));
+    if (g->aborted) {
+      break;
+    }
     if (sc > alpha) {
-      alpha = sc; 
+      alpha = sc;
+    }
+  }
+  ggtl_cache_moves(g, moves);
+
+  return alpha;
+}
+
+/* Returns the position of move C<m> in the order the moves were
+ * generated in, given a table of the moves in that order. Without
+ * a table the list is assumed to be in generation order, and the
+ * running count C<pos> is returned. */
+static int root_index(GGTL_MOVE **order, GGTL_MOVE *m, int pos)
+{
+  int i;
+  if (!order) {
+    return pos;
+  }
+  for (i = 0; order[i] != m; i++)
+    ;
+  return i;
+}
+
+/* Split points must have at least this many plies left to search;
+ * nearer the leaves, handing out the moves costs more than it
+ * saves. */
+#define SPLIT_DEPTH 2
+
+/* A position whose remaining moves are searched by several threads
+ * at once (YBWC or ROOT_PARALLEL). The moves are handed out, and
+ * the results collected, under the lock of the instance that made
+ * it. */
+struct ggtl_split {
+  void *state;          /* copy of the position, for the helpers */
+  GGTL_MOVE *moves;     /* moves not handed out yet */
+  GGTL_MOVE *done;      /* moves handed out */
+  GGTL_MOVE *best;      /* best move, if better than alpha */
+  int ply;              /* PLY of the whole search */
+  int plytogo;
+  int alpha, beta, top;
+  int searched;         /* moves handed out (and the eldest, for YBWC) */
+  int busy;             /* moves being searched */
+  int error;
+  int timeout;          /* a thread ran out of time or was stopped */
+  volatile int cutoff;  /* the rest of the moves need not be searched */
+
+  /* at the root, the scores of all moves are recorded, and ties
+   * are broken as in search_root() */
+  int root;
+  GGTL_MOVE **order;
+  int besti;
+};
+
+/* Search move C<m> at split point C<sp> with the (alpha, beta)
+ * window, as the C<n>th move searched there. Helpers search from
+ * their own copy of the position. The search is aborted if the
+ * split point is cut off. Returns GGTL_ERR if the move could not
+ * be made. */
+static int split_search(GGTL *g, struct ggtl_split *sp, GGTL_MOVE *m,
+                        int alpha, int n)
+{
+  GGTL_VTAB *v = ggtl_vtab(g);
+  GGTL_MOVE *mc;
+  int sc = GGTL_ERR;
+
+  if (g->master) {
+    void *s = v->clone_state(sp->state, g);
+    if (!s) {
+      return GGTL_ERR;
+    }
+    g->states = sl_push(g->states, ggtl_wrap_state(g, s));
+    g->opts[PLY] = sp->ply;
+    g->deadline = g->master->deadline;
+  }
+
+  /* the move belongs to the instance that made the split point, so
+   * it gets a container of our own */
+  mc = ggtl_wrap_move(g, m->data);
+  if (mc && ggtl_move_internal(g, mc)) {
+    volatile int *stop = g->stop;
+    g->stop = &sp->cutoff;
+    sc = sp->root ? pvs(g, alpha, sp->beta, sp->plytogo - 1, 0)
+      : search_move(g, alpha, sp->beta, sp->plytogo, n);
+    g->stop = stop;
+    mc = ggtl_undo_internal(g);
+  }
+  if (mc) {
+    mc->data = NULL;
+    g->mc_cache = sl_push(g->mc_cache, mc);
+  }
+
+  if (g->master) {
+    ggtl_cache_states(g, sl_pop(&g->states));
+  }
+  return sc;
+}
+
+/* Search one of the moves left at split point C<sp>, if any. Called
+ * by C<g>, which is C<owner> or one of its helpers, with the lock
+ * of C<owner> held. Returns false if there was nothing to do. */
+static int split_work(GGTL *g, GGTL *owner, struct ggtl_split *sp)
+{
+  GGTL_MOVE *m;
+  int sc, alpha, n, aborted;
+
+  if (sp->cutoff || !(m = sl_pop(&sp->moves))) {
+    return 0;
+  }
+  alpha = sp->alpha;
+  n = sp->searched++;
+  sp->busy++;
+
+  /* at the root every move is searched with a window one wider, so
+   * that moves as good as the best so far get their exact score */
+  if (sp->root && alpha > GGTL_FITNESS_MIN-1) {
+    alpha--;
+  }
+
+  smp_unlock(owner);
+  sc = split_search(g, sp, m, alpha, n);
+  aborted = g->aborted;
+  g->aborted = 0;
+  if (aborted && (halted(g) 
+                  || (g->deadline > 0 && setstarttime() >= g->deadline))) {
+    aborted = 2;
+  }
+  smp_lock(owner);
+
+  sp->busy--;
+  sp->done = sl_push(sp->done, m);
+  if (sc == GGTL_ERR) {
+    sp->error = sp->cutoff = 1;
+  }
+  else if (aborted == 2) {
+    sp->timeout = sp->cutoff = 1;
+  }
+  else if (!aborted && !sp->cutoff) {
+    int i = sp->root ? root_index(sp->order, m, n) : 0;
+    if (sp->root) {
+      m->fitness = sc;
+    }
+    if (sc > sp->top) {
+      sp->top = sc;
+    }
+    if (sc > sp->alpha || (sp->root && sp->best && sc == sp->alpha
+                           && i < sp->besti)) {
+      sp->alpha = sc;
+      sp->best = m;
+      sp->besti = i;
+    }
+    /* with a full window, keep going after a win to find ties */
+    if (sp->alpha >= sp->beta 
+        && !(sp->root && sp->beta == GGTL_FITNESS_MAX)) {
+      sp->cutoff = 1;
+    }
+  }
+  smp_wake(owner);
+  return 1;
+}
+
+/* Search the moves at split point C<sp> with the helpers, and wait
+ * until they are all done (or the split point is cut off). */
+static void split_run(GGTL *g, struct ggtl_split *sp)
+{
+  smp_lock(g);
+  g->split = sp;
+  smp_wake(g);
+  while (split_work(g, g, sp) || sp->busy) {
+    if (sp->busy) {
+      smp_wait(g);
+    }
+  }
+  g->split = NULL;
+  smp_unlock(g);
+}
+
+/* Fill in the members of split point C<sp> common to all kinds.
+ * Returns false if the position could not be copied. */
+static int split_init(GGTL *g, struct ggtl_split *sp, GGTL_MOVE *moves,
+                      int alpha, int beta, int plytogo)
+{
+  sp->state = g->vtab->clone_state(ggtl_peek_state(g), g);
+  sp->moves = moves;
+  sp->done = sp->best = NULL;
+  sp->ply = ggtl_get(g, PLY);
+  sp->plytogo = plytogo;
+  sp->alpha = alpha;
+  sp->beta = beta;
+  sp->searched = sp->busy = sp->error = sp->timeout = sp->cutoff = 0;
+  sp->root = sp->besti = 0;
+  sp->order = NULL;
+  return sp->state != NULL;
+}
+
+/* Returns true if the moves left at a position with C<plytogo>
+ * plies to search can be searched in parallel */
+static int can_split(GGTL *g, int plytogo)
+{
+  return g->ybwc && g->nhelpers && !g->split && plytogo >= SPLIT_DEPTH;
+}
+
+/* Young Brothers Wait: once the eldest move at a position has been
+ * searched, the rest of C<moves> are searched in parallel by C<g>
+ * and its helpers. Updates C<alpha>, C<best> (the fitness of the
+ * best move) and C<top> like the serial search would, and caches
+ * the moves. Returns the number of moves searched, or 0 if the
+ * moves could not be split (in which case they are left alone). */
+static int split(GGTL *g, GGTL_MOVE **moves, int *alpha, int beta,
+                 int plytogo, int *best, int *top)
+{
+  struct ggtl_split sp;
+  GGTL_MOVE *m, *list = NULL;
+  int height = ggtl_get(g, PLY) - plytogo;
+
+  if (!split_init(g, &sp, NULL, *alpha, beta, plytogo)) {
+    return 0;
+  }
+
+  /* hand the moves out in the order they would have been searched */
+  while ((m = order_pick(g, moves, height))) {
+    list = sl_push(list, m);
+  }
+  sp.moves = sl_reverse(list);
+  sp.top = *top;
+  sp.searched = 1;
+  split_run(g, &sp);
+
+  ai_trace(g, height + 2, "split: %d moves; a/b: %d/%d", 
+    sp.searched - 1, sp.alpha, beta);
+  if (sp.error) {
+    *alpha = GGTL_ERR;
+  }
+  else {
+    if (sp.timeout) {
+      g->aborted = 1;
+    }
+    if (sp.best) {
+      *alpha = sp.alpha;
+      *best = sp.best->fitness;
+    }
+    *top = sp.top;
+    if (sp.alpha >= beta) {
+      g->opts[CUTOFFS]++;
+      order_cutoff(g, sp.best, height, plytogo);
+    }
+  }
+
+  ggtl_cache_moves(g, sp.done);
+  ggtl_cache_moves(g, sp.moves);
+  ggtl_cache_state(g, sp.state);
+  return sp.searched - 1;
+}
+
+/* Generate the moves of the current state with the get_moves_array()
+ * callback, into the buffer for the next level of ab(). Returns
+ * them as a list of the buffer's nodes, which must be given back
+ * with ply_release() rather than cached, or NULL if there are none.
+ * If the buffer can't be used, C<array> is cleared and the moves
+ * are generated with get_moves() instead. */
+static GGTL_MOVE *ply_moves(GGTL *g, int *array)
+{
+  GGTL_VTAB *v = ggtl_vtab(g);
+  struct ggtl_plybuf *b;
+  GGTL_MOVE *moves = NULL;
+  void *state = ggtl_peek_state(g);
+  int i, n;
+
+  if (v->game_over && v->game_over(state, g)) {
+    return NULL;
+  }
+
+  if (g->ply_depth == g->nplybufs) {
+    b = mem_realloc(g, g->plybufs, g->nplybufs * sizeof *b,
+                    (g->nplybufs + 1) * sizeof *b);
+    if (!b) {
+      *array = 0;
+      return ggtl_get_moves(g);
+    }
+    g->plybufs = b;
+    b += g->nplybufs++;
+    b->moves = NULL;
+    b->nodes = NULL;
+    b->size = 0;
+  }
+  b = g->plybufs + g->ply_depth;
+
+  n = v->get_moves_array(state, b->moves, b->size, g);
+  if (n > b->size) {
+    int size = n > 2 * b->size ? n : 2 * b->size;
+    void *mv = mem_realloc(g, b->moves, b->size * v->move_size,
+                           size * v->move_size);
+    GGTL_MOVE *nodes = mv ? mem_realloc(g, b->nodes, b->size * sizeof *nodes,
+                                        size * sizeof *nodes) : NULL;
+
+    if (mv) {
+      b->moves = mv;
+    }
+    if (nodes) {
+      b->nodes = nodes;
+      b->size = size;
+      n = v->get_moves_array(state, b->moves, b->size, g);
+    }
+  }
+  if (n < 0 || n > b->size) {
+    *array = 0;
+    return ggtl_get_moves(g);
+  }
+
+  for (i = n; i-- > 0; ) {
+    GGTL_MOVE *m = b->nodes + i;
+    m->fitness = 0;
+    m->data = (char *)b->moves + i * v->move_size;
+    moves = sl_push(moves, m);
+  }
+  if (moves) {
+    g->ply_depth++;
+  }
+  return moves;
+}
+
+/* Give back the moves generated for ab(): a list from get_moves()
+ * is cached, and a buffer of ply_moves() is freed up for reuse. */
+static void ply_release(GGTL *g, GGTL_MOVE *moves, int array)
+{
+  if (array) {
+    g->ply_depth--;
+  }
+  else {
+    ggtl_cache_moves(g, moves);
+  }
+}
+
+void ply_free(GGTL *g)
+{
+  int i;
+
+  for (i = 0; i < g->nplybufs; i++) {
+    ggtl_dealloc(g, g->plybufs[i].moves);
+    ggtl_dealloc(g, g->plybufs[i].nodes);
+  }
+  ggtl_dealloc(g, g->plybufs);
+  g->plybufs = NULL;
+  g->nplybufs = 0;
+  g->ply_depth = 0;
+
+  ggtl_dealloc(g, g->frames);
+  g->frames = NULL;
+  g->nframes = 0;
+  g->frame_depth = 0;
+}
+
+/* ab() searches with an explicit stack of frames rather than by
+ * calling itself, so that an incremental search (see ai_step()) can
+ * stop anywhere in the tree and carry on later. A frame holds what
+ * a recursive alpha-beta search would keep in local variables for
+ * one position, and the child search it is waiting for: its window,
+ * depth, and what its score is for (the phase). The frame at the
+ * bottom of a run of ab() is a base frame, which stands for the
+ * caller: it has no moves of its own, and the score of its child is
+ * handed back rather than searched further. */
+struct ggtl_frame {
+  GGTL_MOVE *moves;     /* moves left to search */
+  GGTL_MOVE *move;      /* the move being searched */
+  unsigned long key;
+  int alpha, beta, origalpha, plytogo;
+  int best, ttmove, top, searched;
+  int usett, array, futile, base;
+  int phase;
+  int bound;            /* ProbCut: the bound tested, then the score */
+  int calpha, cbeta, cplytogo, cnull;   /* the child search */
+};
+
+/* what the child search of a frame is for */
+enum {
+  F_NULL,               /* the position after a null move */
+  F_PROBCUT_HI,         /* ProbCut's shallow searches */
+  F_PROBCUT_LO,
+  F_LMR,                /* the move made, to a reduced depth */
+  F_PVS,                /* the move made, with a null window */
+  F_FULL                /* the move made */
+};
+
+/* what ab() does next */
+enum {
+  A_ENTER,              /* search the child of the top frame */
+  A_RESULT,             /* hand the score of a child to the top frame */
+  A_NEXT,               /* search the next move of the top frame */
+  A_DONE                /* hand the score back to the caller */
+};
+
+#define TOP(g) ((g)->frames + (g)->frame_depth - 1)
+
+/* Push a frame, growing the stack if need be. Returns it, or NULL if
+ * the stack could not be grown. Frames move when it grows, so
+ * pointers to them must be fetched again after a push, and after a
+ * split (whose searches push frames of their own). */
+static struct ggtl_frame *frame_push(GGTL *g)
+{
+  if (g->frame_depth == g->nframes) {
+    int n = g->nframes ? 2 * g->nframes : 16;
+    struct ggtl_frame *f = mem_realloc(g, g->frames, g->nframes * sizeof *f,
+                                       n * sizeof *f);
+    if (!f) {
+      return NULL;
     }
-    state = ggtl_undo(g);
-    assert(state != NULL);
+    g->frames = f;
+    g->nframes = n;
+  }
+  return g->frames + g->frame_depth++;
+}
+
+/* Ask for the child search of frame C<f>. Returns A_ENTER. */
+static int child(struct ggtl_frame *f, int phase, int alpha, int beta,
+                 int plytogo, int after_null)
+{
+  f->phase = phase;
+  f->calpha = alpha;
+  f->cbeta = beta;
+  f->cplytogo = plytogo;
+  f->cnull = after_null;
+  return A_ENTER;
+}
+
+/* Returns the trace level of the position of frame C<f> */
+static int tracelevel(GGTL *g, struct ggtl_frame *f)
+{
+  return ggtl_get(g, PLY) - f->plytogo + 2;
+}
+
+/* Pop the top frame, and hand back C<sc> as its score. Returns
+ * A_RESULT. */
+static int leave(GGTL *g, int sc, int *v)
+{
+  struct ggtl_frame *f = TOP(g);
+
+  ply_release(g, f->moves, f->array);
+  g->frame_depth--;
+  *v = sc;
+  return A_RESULT;
+}
+
+/* The moves of the top frame have all been searched, or there is a
+ * cutoff: store its score in the transposition table and leave it. */
+static int finish(GGTL *g, int *v)
+{
+  struct ggtl_frame *f = TOP(g);
+  int alpha = f->alpha;
+
+  /* failing soft, return the best score even if it is below alpha,
+   * which gives a tighter bound */
+  if (g->fail_soft && f->searched && alpha == f->origalpha
+      && f->top < alpha) {
+    alpha = f->top;
   }
 
   {
     char skipped[50] = {0};
-    if (moves) {
-      int count = sl_count(moves);
+    if (f->moves) {
+      int count = sl_count(f->moves);
       char *plural = count == 1 ? "" : "es";
       sprintf(skipped, " (%d branch%s skipped)", count, plural);
     }
-    ai_trace(g, tracelevel, "a/b: %d/%d%s", alpha, beta, skipped);
+    ai_trace(g, tracelevel(g, f), "a/b: %d/%d%s", alpha, f->beta, skipped);
   }
 
-  /* if we broke out of the loop early, 
-     cache the rest of the moves */
-  ggtl_cache_moves(g, moves);
+  if (f->usett && alpha != GGTL_ERR && !g->aborted) {
+    int bound = alpha >= f->beta ? TT_LOWER :
+                alpha > f->origalpha ? TT_EXACT : TT_UPPER;
+    tt_store(g, f->key, f->plytogo, bound, alpha, f->best);
+  }
 
-  return alpha;
+  /* if we broke out of the loop early, the rest of the moves are
+   * cached here */
+  return leave(g, alpha, v);
 }
 
-GGTL_MOVE *ai_fixed(GGTL *g, GGTL_MOVE *moves)
+/* Get ready to search the moves of the top frame. Returns A_NEXT. */
+static int moves_start(GGTL *g)
 {
-  GGTL_STATE *state;
-  GGTL_MOVE *m, *best;
-  int alpha, beta;
+  GGTL_VTAB *v = ggtl_vtab(g);
+  struct ggtl_frame *f = TOP(g);
+
+  /* futility pruning: near the horizon, if the position is so bad
+   * that even a large gain would not bring it above alpha, only
+   * the first move is searched */
+  f->futile = ggtl_get(g, FUTILITY)
+    && f->plytogo <= ggtl_get(g, FUTILITY_DEPTH)
+    && v->eval(ggtl_peek_state(g), g) + ggtl_get(g, FUTILITY) * f->plytogo
+       <= f->alpha;
+
+  if (f->usett) {
+    f->moves = number_moves(f->moves, f->best);
+  }
+  f->ttmove = f->best;
+  return A_NEXT;
+}
 
-  assert(1 < sl_count(moves));
+/* Null-move pruning: let the side to move at frame C<f> pass, and
+ * search the position to a reduced depth with a null window. If it
+ * still scores beta or better, a real move is assumed to do so too
+ * (see result()). Returns true if the null move was made. */
+static int null_move(GGTL *g, struct ggtl_frame *f)
+{
+  GGTL_VTAB *v = ggtl_vtab(g);
+  int r = ggtl_get(g, NULL_MOVE);
 
-  alpha = GGTL_FITNESS_MIN-1;  /* loss should be better than this */
-  beta = GGTL_FITNESS_MAX;
+  if (!r || !v->null_move || !v->null_unmove
+      || f->plytogo <= r || f->beta >= GGTL_FITNESS_MAX) {
+    return 0;
+  }
+  if (!v->null_move(ggtl_peek_state(g), g)) {
+    return 0;
+  }
+  (void)child(f, F_NULL, -f->beta, -f->beta + 1, f->plytogo - 1 - r, 1);
+  return 1;
+}
 
-  state = NULL;
-  best = NULL;
-  while ((m = sl_pop(&moves))) {
-    if (ggtl_move_internal(g, m)) {
-      int sc = -ab(g, -beta, -alpha, ggtl_get(g, PLY) - 1);
-      ai_trace(g, 2, "a/b: %d/%d (visited: %d)", sc, beta,
-        ggtl_get(g, VISITED));
-      m = ggtl_undo_internal(g); 
+/* End ProbCut at the top frame. If C<cut>, the position is cut off
+ * with the score in the frame's bound; otherwise its moves are
+ * searched. */
+static int probcut_end(GGTL *g, int cut, int *v)
+{
+  struct ggtl_frame *f = TOP(g);
 
-      /* It is important that the _first_ move to be found with
-       * the given alpha-beta value is picked, as latter ones
-       * might be worse (since they might be victims of cutoffs).  */
-      if (sc > alpha) {
-        GGTL_MOVE *tmp = best;
-        best = m;
-        m = tmp;
-        alpha = sc;
-      }
-      ggtl_cache_moves(g, m);
+  g->in_probcut = 0;
+  g->opts[PROBCUT_CUTS] += cut;
+  if (cut) {
+    ai_trace(g, tracelevel(g, f), "probcut: %d", f->bound);
+    return leave(g, f->bound, v);
+  }
+  return moves_start(g);
+}
+
+/* ProbCut's second test: is the deep score at the top frame likely
+ * to be no more than alpha? */
+static int probcut_low(GGTL *g, int *v)
+{
+  struct ggtl_frame *f = TOP(g);
+  struct ggtl_probcut *p = g->probcut + f->plytogo;
+  double bound = (f->alpha - g->probcut_t * p->sigma - p->b) / p->a;
+
+  if (bound > GGTL_FITNESS_MIN && bound < GGTL_FITNESS_MAX) {
+    int a = (int)bound;
+    if (a > bound) {
+      a--;
     }
-    else {
-      ggtl_cache_moves(g, m);
-      ggtl_cache_moves(g, moves);
-      ggtl_cache_moves(g, best);
-      return NULL;
+    f->bound = a;
+    return child(f, F_PROBCUT_LO, a, a + 1, p->shallow, 0);
+  }
+  return probcut_end(g, 0, v);
+}
+
+/* ProbCut: if a shallow search predicts that a deep one would
+ * score well outside the (alpha, beta) window, the position is cut
+ * off. The prediction is a linear function of the shallow score,
+ * with parameters for each depth loaded from a file. Starts the
+ * shallow search of the top frame's position for its first test. */
+static int probcut(GGTL *g, int *v)
+{
+  struct ggtl_frame *f = TOP(g);
+  struct ggtl_probcut *p;
+  float t = g->probcut_t;
+  double bound;
+
+  if (t <= 0 || g->in_probcut || f->plytogo < 0
+      || f->plytogo >= PROBCUT_DEPTHS || !g->probcut[f->plytogo].shallow) {
+    return moves_start(g);
+  }
+  p = g->probcut + f->plytogo;
+
+  /* searches of this position to the shallow depth don't use
+   * ProbCut themselves */
+  g->in_probcut = 1;
+
+  /* is the deep score likely to be at least beta? */
+  bound = (f->beta + t * p->sigma - p->b) / p->a;
+  if (bound > GGTL_FITNESS_MIN && bound < GGTL_FITNESS_MAX) {
+    int b = (int)bound;
+    if (b < bound) {
+      b++;
     }
-      
-    assert(alpha != GGTL_ERR);
+    f->bound = b;
+    return child(f, F_PROBCUT_HI, b - 1, b, p->shallow, 0);
   }
-  assert(best != NULL);
-  m = best;
+  return probcut_low(g, v);
+}
 
-  ggtl_cache_moves(g, moves);
+/* Visit the position the top frame asks for, from the point of view
+ * of the side to move there. If it can be scored at once, its score
+ * is put in C<v> and A_RESULT is returned; otherwise a frame is
+ * pushed for it. */
+static int enter(GGTL *g, int *v)
+{
+  GGTL_VTAB *vt = ggtl_vtab(g);
+  struct ggtl_frame *f = TOP(g);
+  GGTL_MOVE *moves;
+  unsigned long key = 0;
+  int alpha = f->calpha, beta = f->cbeta, plytogo = f->cplytogo;
+  int after_null = f->cnull;
+  int usett = g->tt && vt->hash;
+  int best = -1;
+  int tracelevel = ggtl_get(g, PLY) - plytogo + 2;
+  /* moves that may be split among helpers can't be in a buffer of
+   * ours, as they are cached by whoever searches them */
+  int array = vt->get_moves_array && vt->move_size > 0
+    && !can_split(g, plytogo);
+
+  g->opts[VISITED]++;
+  if (timeout(g)) {
+    *v = 0;     /* ignored; the search is being unwound */
+    return A_RESULT;
+  }
+
+  if (usett) {
+    key = vt->hash(ggtl_peek_state(g), g);
+    if (tt_probe(g, key, plytogo, alpha, beta, v, &best)) {
+      ai_trace(g, tracelevel, "tt hit: %d", *v);
+      return A_RESULT;
+    }
+  }
   
-  ai_trace(g, 1, 
-    "best branch: %d (ply %d search; %d states visited)",
-    alpha, ggtl_get(g, PLY), ggtl_get(g, VISITED));
+  moves = array ? ply_moves(g, &array) : ggtl_get_moves(g);
+  if (moves && plytogo <= 0 && vt->get_noisy_moves 
+      && ggtl_get(g, QS_DEPTH) > 0) {
+    ply_release(g, moves, array);
+    *v = quiesce(g, alpha, beta, 0);
+    ai_trace(g, tracelevel, "quiescence: %d", *v);
+    if (usett && !g->aborted && *v != GGTL_ERR) {
+      int bound = *v >= beta ? TT_LOWER :
+                  *v > alpha ? TT_EXACT : TT_UPPER;
+      tt_store(g, key, 0, bound, *v, -1);
+    }
+    return A_RESULT;
+  }
+  if (!moves || plytogo <= 0) {
+    if (!moves) { g->saw_end = 1; }
+    else { ply_release(g, moves, array); }
+    *v = vt->eval(ggtl_peek_state(g), g);
+    ai_trace(g, tracelevel, "%s: %d", 
+      moves ? "ply limit" : "leaf state", *v);
+    if (usett) {
+      tt_store(g, key, moves ? 0 : TT_DEPTH_END, TT_EXACT, *v, -1);
+    }
+    return A_RESULT;
+  }
 
-  return m;
+  f = frame_push(g);
+  if (!f) {
+    ply_release(g, moves, array);
+    g->aborted = 1;
+    *v = 0;
+    return A_RESULT;
+  }
+  f->moves = moves;
+  f->move = NULL;
+  f->key = key;
+  f->alpha = f->origalpha = alpha;
+  f->beta = beta;
+  f->plytogo = plytogo;
+  f->best = best;
+  f->top = GGTL_FITNESS_MIN-1;
+  f->searched = 0;
+  f->usett = usett;
+  f->array = array;
+  f->base = 0;
+
+  /* two null moves in a row would just search the same position */
+  if (!after_null && null_move(g, f)) {
+    return A_ENTER;
+  }
+  return probcut(g, v);
 }
 
+/* Search the move just made at frame C<f> with the frame's window.
+ * In Principal Variation Search mode, all but the first move are
+ * searched with a null window first, and only searched again if
+ * they turn out better (see result()). */
+static int search_pvs(GGTL *g, struct ggtl_frame *f)
+{
+  if (g->pvs && f->searched) {
+    return child(f, F_PVS, -f->alpha - 1, -f->alpha, f->plytogo - 1, 0);
+  }
+  return child(f, F_FULL, -f->beta, -f->alpha, f->plytogo - 1, 0);
+}
 
-/*
+/* Search the move just made at frame C<f>. With late move
+ * reductions, moves after the first LMR ones are first searched one
+ * ply shallower with a null window, and searched again to full
+ * depth only if that shows they could be better than alpha. */
+static int search_made(GGTL *g, struct ggtl_frame *f)
+{
+  int lmr = ggtl_get(g, LMR);
 
-=item ITERATIVE
+  if (lmr && f->searched >= lmr && f->plytogo > ggtl_get(g, LMR_DEPTH)) {
+    g->opts[LMR_REDUCED]++;
+    return child(f, F_LMR, -f->alpha - 1, -f->alpha, f->plytogo - 2, 0);
+  }
+  return search_pvs(g, f);
+}
 
-This AI performs an iterative deepening Alpha-Beta search to find
-the best possible move at the greatest depth that can be searched
-in a given time. The time allowed for a search can be set with
-C<ggtl_set()>; use C<ggtl_set(g, TIME, 0.350)> to set the allowed
-time to 350 milliseconds.
+/* The move made at the top frame has been searched, and scored
+ * C<sc>. At a base frame, that is the score handed back. */
+static int scored(GGTL *g, int sc, int *v)
+{
+  struct ggtl_frame *f = TOP(g);
+  GGTL_MOVE *m = f->move, *undone;
 
-=cut
+  if (f->base) {
+    g->frame_depth--;
+    *v = sc;
+    return A_DONE;
+  }
 
-*/
+  if (!g->aborted) {
+    if (sc > f->top) {
+      f->top = sc;
+    }
+    if (sc > f->alpha) {
+      f->alpha = sc; 
+      f->best = m->fitness;
+    }
+    if (f->alpha >= f->beta) {
+      g->opts[CUTOFFS]++;
+      g->opts[FIRST_CUTOFFS] += !f->searched;
+      order_cutoff(g, m, ggtl_get(g, PLY) - f->plytogo, f->plytogo);
+    }
+  }
+  undone = ggtl_undo_internal(g);
+  assert(undone == m);
+  if (!f->array) {
+    ggtl_cache_moves(g, undone);
+  }
+  f->move = NULL;
+  if (g->aborted) {
+    return finish(g, v);
+  }
+  f->searched++;
+  return A_NEXT;
+}
 
-GGTL_MOVE *ai_iterative(GGTL *g, GGTL_MOVE *moves)
+/* Hand the score C<v> of the child search of the top frame to it,
+ * and carry on with what the frame does next */
+static int result(GGTL *g, int *v)
 {
-  GGTL_MOVE *best;
-  int ply, saved_ply;
-  double start;
+  GGTL_VTAB *vt = ggtl_vtab(g);
+  struct ggtl_frame *f = TOP(g);
+  int sc = -*v;
+
+  switch (f->phase) {
+  case F_NULL:
+    if (vt->null_unmove(ggtl_peek_state(g), g)
+        && sc >= f->beta && !g->aborted) {
+      g->opts[NULL_CUTOFFS]++;
+      ai_trace(g, tracelevel(g, f), "null move: %d", f->beta);
+      return leave(g, f->beta, v);
+    }
+    return probcut(g, v);
 
-  assert(1 < sl_count(moves));
-  saved_ply = ggtl_get(g, PLY);
-  start = setstarttime();
+  /* the shallow searches are of the same position */
+  case F_PROBCUT_HI:
+    if (*v >= f->bound && !g->aborted) {
+      f->bound = f->beta;
+      return probcut_end(g, 1, v);
+    }
+    return probcut_low(g, v);
 
-  best = NULL;
-  for (ply = 1;; ply++) { 
-    GGTL_MOVE *m;
+  case F_PROBCUT_LO:
+    if (*v <= f->bound && !g->aborted) {
+      f->bound = f->alpha;
+      return probcut_end(g, 1, v);
+    }
+    return probcut_end(g, 0, v);
 
-    ggtl_set(g, PLY, ply);
-    m = ai_fixed(g, moves);
-    if (m) {
-      ggtl_cache_moves(g, best);
-      best = m;
-      g->opts[PLY_REACHED] = ply;
+  case F_LMR:
+    if (sc <= f->alpha || g->aborted) {
+      return scored(g, sc, v);
     }
+    return search_pvs(g, f);
 
-    if (!havetimeleft(start, g->time_to_search / 2.0)) {
-      break;
+  case F_PVS:
+    if (sc <= f->alpha || sc >= f->beta) {
+      return scored(g, sc, v);
     }
-    
-    moves = ggtl_get_moves(g);
+    return child(f, F_FULL, -f->beta, -f->alpha, f->plytogo - 1, 0);
   }
-  ggtl_set(g, PLY, saved_ply);
+  return scored(g, sc, v);
+}
 
-  return best;
+/* Make the next move at the top frame and start its search, or
+ * leave the frame if there are no more moves to search there. */
+static int next(GGTL *g, int *v)
+{
+  int i = g->frame_depth - 1;
+  struct ggtl_frame *f = g->frames + i;
+  int height = ggtl_get(g, PLY) - f->plytogo;
+  GGTL_MOVE *m;
+
+  if (f->alpha >= f->beta) {
+    return finish(g, v);
+  }
+
+  /* YBWC: once the eldest move has been searched, the rest may be
+   * searched in parallel */
+  if (f->searched == 1 && !f->futile && !f->array && f->moves
+      && can_split(g, f->plytogo)) {
+    GGTL_MOVE *moves = f->moves;
+    int alpha = f->alpha, best = f->best, top = f->top;
+    int n = split(g, &moves, &alpha, f->beta, f->plytogo, &best, &top);
+
+    f = g->frames + i;
+    f->moves = moves;
+    f->alpha = alpha;
+    f->best = best;
+    f->top = top;
+    if (n) {
+      f->searched += n;
+      f->moves = NULL;
+      return finish(g, v);
+    }
+  }
+
+  /* the move from the transposition table goes first */
+  m = !f->searched && f->ttmove >= 0 ? sl_pop(&f->moves) 
+    : order_pick(g, &f->moves, height);
+  if (!m) {
+    return finish(g, v);
+  }
+  if (f->futile && f->searched) {
+    g->opts[FUTILITY_PRUNED] += 1 + sl_count(f->moves);
+    f->moves = sl_push(f->moves, m);
+    f->top = GGTL_FITNESS_MAX;  /* no bound on the moves skipped */
+    return finish(g, v);
+  }
+
+  if (!ggtl_move_internal(g, m)) {
+    if (!f->array) {
+      ggtl_cache_moves(g, m);
+    }
+    f->alpha = GGTL_ERR;
+    return finish(g, v);
+  }
+  f->move = m;
+  return search_made(g, f);
+}
+
+/* The alpha-beta search. Carries on from C<act> until the base frame
+ * of this run hands back its score, which is put in C<sc>. With a
+ * node limit set (see ai_step()), it instead stops before visiting a
+ * state over the limit and returns false, leaving the stack as it
+ * is; calling it again with A_ENTER carries on from there. */
+static int ab(GGTL *g, int act, int *sc)
+{
+  int v = 0;
+
+  for (;;) {
+    switch (act) {
+    case A_ENTER:
+      if (g->node_limit
+          && g->opts[VISITED] + g->opts[QS_VISITED] >= g->node_limit) {
+        return 0;
+      }
+      act = enter(g, &v);
+      break;
+    case A_RESULT:
+      act = result(g, &v);
+      break;
+    case A_NEXT:
+      act = next(g, &v);
+      break;
+    default:
+      *sc = v;
+      return 1;
+    }
+  }
+}
+
+/* Push the base frame of a search of the move just made by the
+ * caller, with the (alpha, beta) window from the point of view of
+ * the player that made it. Returns NULL, and aborts the search, if
+ * there is no room for it. */
+static struct ggtl_frame *base_push(GGTL *g, int alpha, int beta,
+                                    int plytogo, int searched)
+{
+  struct ggtl_frame *f = frame_push(g);
+
+  if (!f) {
+    g->aborted = 1;
+    return NULL;
+  }
+  f->moves = f->move = NULL;
+  f->alpha = alpha;
+  f->beta = beta;
+  f->plytogo = plytogo;
+  f->searched = searched;
+  f->array = 0;
+  f->base = 1;
+  return f;
+}
+
+/* Search the move just made with the (alpha, beta) window from the
+ * point of view of the player that made it, to C<plytogo> plies
+ * below it, as the C<searched>th move of its position. See
+ * search_pvs(). */
+static int pvs(GGTL *g, int alpha, int beta, int plytogo, int searched)
+{
+  struct ggtl_frame *f = base_push(g, alpha, beta, plytogo + 1, searched);
+  int sc = 0;
+
+  if (f) {
+    (void)ab(g, search_pvs(g, f), &sc);
+  }
+  return sc;
+}
+
+/* Search the move just made as pvs() does, from a position with
+ * C<plytogo> plies left to search; see search_made(). */
+static int search_move(GGTL *g, int alpha, int beta, int plytogo,
+                       int searched)
+{
+  struct ggtl_frame *f = base_push(g, alpha, beta, plytogo, searched);
+  int sc = 0;
+
+  if (f) {
+    (void)ab(g, search_made(g, f), &sc);
+  }
+  return sc;
+}
+
+/* Returns the root moves C<moves> in order of fitness, with C<best>
+ * first. If there is no best move and the search was aborted,
+ * C<first> is put first instead. */
+static GGTL_MOVE *root_sort(GGTL *g, GGTL_MOVE *moves, GGTL_MOVE *best,
+                            GGTL_MOVE *first, int alpha)
+{
+  GGTL_MOVE *m;
+
+  /* moves not searched keep the fitness from earlier searches */
+  moves = sl_mergesort(moves, fitness_cmp);
+  if (!best && g->aborted) {
+    best = first;
+  }
+  if (best && moves != best) {
+    for (m = moves; m->next != best; m = m->next)
+      ;
+    m->next = best->next;
+    best->next = moves;
+  }
+  
+  ai_trace(g, 1, 
+    "best branch: %d (ply %d search; %d states visited)",
+    alpha, ggtl_get(g, PLY), ggtl_get(g, VISITED));
+
+  return best ? best : moves;
+}
+
+/* search_root() for ROOT_PARALLEL: the root moves are shared out
+ * among the helpers. All moves are searched with a window one wider
+ * than the best score so far, so that the same move is picked as
+ * by the serial search. */
+static GGTL_MOVE *search_root_split(GGTL *g, GGTL_MOVE *moves,
+                                    GGTL_MOVE **order, int alpha, 
+                                    int beta, int *score)
+{
+  struct ggtl_split sp;
+  GGTL_MOVE *m;
+
+  if (!split_init(g, &sp, moves, alpha, beta, ggtl_get(g, PLY))) {
+    ggtl_cache_moves(g, moves);
+    return NULL;
+  }
+  sp.root = 1;
+  sp.order = order;
+  sp.top = GGTL_FITNESS_MIN-1;
+  split_run(g, &sp);
+  ggtl_cache_state(g, sp.state);
+
+  if (sp.error) {
+    ggtl_cache_moves(g, sp.done);
+    ggtl_cache_moves(g, sp.moves);
+    return NULL;
+  }
+  g->aborted = sp.timeout;
+  *score = sp.alpha;
+
+  while ((m = sl_pop(&sp.moves))) {
+    sp.done = sl_push(sp.done, m);
+  }
+  return root_sort(g, sp.done, sp.best, moves, sp.alpha);
+}
+
+/* Search root move C<m> here, for search_root_remote() when no
+ * worker can. Returns GGTL_ERR if the move could not be made. */
+static int remote_fallback(GGTL *g, GGTL_MOVE *m, int alpha, int beta)
+{
+  int sc;
+
+  if (!ggtl_move_internal(g, m)) {
+    return GGTL_ERR;
+  }
+  sc = pvs(g, alpha - 1, beta, ggtl_get(g, PLY) - 1, 0);
+  (void)ggtl_undo_internal(g);
+  return sc;
+}
+
+/* search_root() with remote workers (see ggtl_add_worker()). Each
+ * root move is sent to an idle worker; as for ROOT_PARALLEL, it is
+ * searched with a window one wider than the best score so far. A
+ * move is searched here if its worker fails or none are left. */
+static GGTL_MOVE *search_root_remote(GGTL *g, GGTL_MOVE *moves,
+                                     GGTL_MOVE **order, int alpha,
+                                     int beta, int *score)
+{
+  GGTL_MOVE *m, *best, *done, *first = moves;
+  struct ggtl_worker *w;
+  int besti, i, sc, sent, pos = 0, error = 0, ply = ggtl_get(g, PLY);
+
+  best = done = NULL;
+  besti = 0;
+  for (;;) {
+    /* with a full window, keep going after a win to find ties */
+    int go = !error && !g->aborted
+      && (alpha < beta || beta == GGTL_FITNESS_MAX);
+
+    if (go && moves && (w = net_idle(g))) {
+      m = sl_pop(&moves);
+      i = root_index(order, m, pos++);
+      if (!ggtl_move_internal(g, m)) {
+        done = sl_push(done, m);
+        error = 1;
+        continue;
+      }
+      sent = net_send(g, w, ply, ply - 1, alpha - 1, beta);
+      m = ggtl_undo_internal(g);
+      if (sent) {
+        w->m = m;
+        w->pos = i;
+        continue;
+      }
+      sc = GGTL_ERR;
+    }
+    else if (go && moves && !net_busy(g)) {
+      /* all the workers have failed */
+      m = sl_pop(&moves);
+      i = root_index(order, m, pos++);
+      sc = GGTL_ERR;
+    }
+    else if ((w = net_recv(g, &sc))) {
+      m = w->m;
+      i = w->pos;
+      w->m = NULL;
+    }
+    else {
+      break;
+    }
+
+    if (sc == GGTL_ERR) {
+      if (!go) {
+        done = sl_push(done, m);
+        continue;
+      }
+      sc = remote_fallback(g, m, alpha, beta);
+      if (sc == GGTL_ERR) {
+        error = 1;
+      }
+      if (sc == GGTL_ERR || g->aborted) {
+        done = sl_push(done, m);
+        continue;
+      }
+    }
+
+    ai_trace(g, 2, "a/b: %d/%d (visited: %d)", sc, beta,
+      ggtl_get(g, VISITED));
+    m->fitness = sc;
+    if (sc > alpha || (best && sc == alpha && i < besti)) {
+      best = m;
+      besti = i;
+      alpha = sc;
+    }
+    done = sl_push(done, m);
+  }
+
+  if (error) {
+    ggtl_cache_moves(g, moves);
+    ggtl_cache_moves(g, done);
+    return NULL;
+  }
+  *score = alpha;
+
+  while ((m = sl_pop(&moves))) {
+    done = sl_push(done, m);
+  }
+  return root_sort(g, done, best, first, alpha);
+}
+
+/* Search each of the root moves to the current PLY with the
+ * (alpha, beta) window and record its score in its fitness member.
+ * The search stops early if a move scores beta or better. Returns
+ * the list sorted in order of descending fitness, with the best
+ * move at its head, or NULL on error (in which case the moves are
+ * cached). The best score is put in C<score>; if it is not above
+ * alpha, no move was better than that. (When failing soft, the
+ * score of the best move is put there even if it is below alpha.)
+ *
+ * If the search is aborted, the best move among those searched in
+ * full is put at the head of the list, or the first move if none
+ * of them scored above alpha.
+ *
+ * If the moves are not in the order they were generated in,
+ * C<order> must hold them in that order. This is so the same move
+ * is picked among equals no matter which order they are searched
+ * in. */
+static GGTL_MOVE *search_root(GGTL *g, GGTL_MOVE *moves, GGTL_MOVE **order,
+                              int alpha, int beta, int *score)
+{
+  GGTL_MOVE *m, *best, *done, *first = moves;
+  int besti, pos, top = GGTL_FITNESS_MIN-1;
+
+  if (g->nworkers && g->vtab->serialize && !g->pvs && !g->fail_soft) {
+    return search_root_remote(g, moves, order, alpha, beta, score);
+  }
+  if (g->root_parallel && g->nhelpers) {
+    return search_root_split(g, moves, order, alpha, beta, score);
+  }
+
+  best = done = NULL;
+  besti = 0;
+  /* with a full window, keep going after a win to find ties */
+  for (pos = 0; (alpha < beta || beta == GGTL_FITNESS_MAX)
+       && (m = sl_pop(&moves)); pos++) {
+    int i = root_index(order, m, pos);
+    if (ggtl_move_internal(g, m)) {
+      /* It is important that the _first_ move to be found with
+       * the given alpha-beta value is picked, as latter ones
+       * might be worse (since they might be victims of cutoffs).
+       * Moves generated before the best one so far are searched
+       * with a window one wider, to see if they are as good.  */
+      int tie = best && i < besti;
+      int sc = pvs(g, alpha - tie, beta, ggtl_get(g, PLY) - 1, best != NULL);
+      m = ggtl_undo_internal(g); 
+      if (g->aborted) {
+        done = sl_push(done, m);
+        break;
+      }
+      ai_trace(g, 2, "a/b: %d/%d (visited: %d)", sc, beta,
+        ggtl_get(g, VISITED));
+      m->fitness = sc;
+      if (sc > top) {
+        top = sc;
+      }
+
+      if (sc > alpha || (tie && sc == alpha)) {
+        best = m;
+        besti = i;
+        alpha = sc;
+      }
+      done = sl_push(done, m);
+    }
+    else {
+      ggtl_cache_moves(g, m);
+      ggtl_cache_moves(g, moves);
+      ggtl_cache_moves(g, done);
+      return NULL;
+    }
+      
+    assert(alpha != GGTL_ERR);
+  }
+  *score = g->fail_soft && !best ? top : alpha;
+
+  while ((m = sl_pop(&moves))) {
+    done = sl_push(done, m);
+  }
+  return root_sort(g, done, best, first, alpha);
+}
+
+GGTL_MOVE *ai_fixed(GGTL *g, GGTL_MOVE *moves)
+{
+  GGTL_MOVE *best;
+  int score;
+
+  assert(1 < sl_count(moves));
+
+  if (ggtl_get(g, ROOT_PARALLEL) && !g->pvs && !g->ybwc) {
+    g->root_parallel = 1;
+    smp_start(g, ai_worker);
+  }
+
+  /* loss should be better than the lower bound */
+  moves = search_root(g, moves, NULL, GGTL_FITNESS_MIN-1, GGTL_FITNESS_MAX,
+    &score);
+  if (moves) {
+    g->opts[SCORE] = score;
+  }
+  best = sl_pop(&moves);
+  ggtl_cache_moves(g, moves);
+
+  if (g->root_parallel) {
+    smp_stop(g, 1);
+    g->root_parallel = 0;
+  }
+
+  return best;
+}
+
+
+/*
+
+=item ITERATIVE
+
+This AI performs an iterative deepening Alpha-Beta search to find
+the best possible move at the greatest depth that can be searched
+in a given time. The time allowed for a search can be set with
+C<ggtl_set()>; use C<ggtl_set(g, TIME, 0.350)> to set the allowed
+time to 350 milliseconds.
+
+The moves at the root are searched in order of their score in the
+previous iteration, so the best move found so far is always tried
+first. The moves picked are the same as those of FIXED at the
+depth reached.
+
+If the C<ASPIRATION> option is set (see L<ggtl(3)|ggtl>), each
+iteration after the first starts with a narrow window of that
+width on either side of the score from the previous iteration. If
+the score falls outside the window, the window is made
+C<ASP_GROWTH> times wider on that side and the iteration is
+searched again. This saves work when the scores of successive
+iterations are close.
+
+By default the time limit is soft: a new iteration is not started
+if half the time allowed has been used, but one that has been
+started always runs to completion, and can take several times
+longer than the limit. If the C<HARD_DEADLINE> option is set, the
+search is aborted as soon as the time is up. The clock is checked
+every C<POLL> states visited. The move picked is then the best
+one found in the last complete iteration, unless a move that
+scored better than it was found in the aborted one. How far a
+search went past the time limit can be read from the C<OVERSHOOT>
+option.
+
+If the C<THREADS> option is set above 1, that many threads search
+at the same time ("Lazy SMP"). The extra threads have their own
+copies of the position and search it with iterative deepening,
+half of them a ply ahead of the main thread, until the main thread
+is done. They share the transposition table with it, so the main
+thread can use what they find and get deeper in the same time. The
+move picked is the main thread's, but it is no longer the same
+from run to run. The states visited by each thread can be read
+with C<ggtl_get_thread()>; see L<ggtl(3)|ggtl>. If the
+C<ROOT_PARALLEL> option is set, the threads share out the root
+moves instead, and the move picked is the same as with one thread.
+
+The search can also be started before it is the AI's turn, while
+the opponent is thinking; see C<ggtl_ponder_start()> in
+L<ggtl(3)|ggtl>. The clock then starts when the opponent moves,
+and by then the search may already be several plies deep.
+
+=cut
+
+*/
+
+/* Returns C<score> moved C<width> towards C<limit>, but not past it.
+ * The limits are near the ends of the int range, so take care not
+ * to overflow. A width of GGTL_FITNESS_MAX always reaches the limit. */
+static int widen(int score, int width, int limit)
+{
+  if (width >= GGTL_FITNESS_MAX) {
+    return limit;
+  }
+  if (limit > score) {
+    return limit - width > score ? score + width : limit;
+  }
+  return limit + width < score ? score - width : limit;
+}
+
+/* Returns C<width> made C<growth> times wider */
+static int grow(int width, int growth)
+{
+  if (growth < 2 || width > GGTL_FITNESS_MAX / growth) {
+    return GGTL_FITNESS_MAX;
+  }
+  return width * growth;
+}
+
+/* Search the root moves to the current PLY, with an aspiration
+ * window around the previous iteration's score if ASPIRATION is
+ * set. Returns the moves with the best at the head, or NULL on
+ * error; the score of the best move is put in C<score>. */
+static GGTL_MOVE *aspiration(GGTL *g, GGTL_MOVE *moves, GGTL_MOVE **order,
+                             int *score)
+{
+  int alpha = GGTL_FITNESS_MIN-1;
+  int beta = GGTL_FITNESS_MAX;
+  int width = ggtl_get(g, ASPIRATION);
+
+  /* start with a narrow window around the previous score, and
+   * widen it on the side the search falls out of */
+  if (width > 0 && ggtl_get(g, PLY) > 1) {
+    alpha = widen(*score, width, alpha);
+    beta = widen(*score, width, beta);
+  }
+
+  for (;;) {
+    int sc;
+
+    /* the best move of the previous iteration is searched first */
+    moves = search_root(g, moves, order, alpha, beta, &sc);
+    if (!moves || g->aborted) {
+      break;
+    }
+
+    if (sc <= alpha && alpha > GGTL_FITNESS_MIN-1) {
+      width = grow(width, ggtl_get(g, ASP_GROWTH));
+      alpha = widen(*score, width, GGTL_FITNESS_MIN-1);
+      ai_trace(g, 1, "fail low; new window %d/%d", alpha, beta);
+    }
+    else if (sc >= beta && beta < GGTL_FITNESS_MAX) {
+      width = grow(width, ggtl_get(g, ASP_GROWTH));
+      beta = widen(*score, width, GGTL_FITNESS_MAX);
+      ai_trace(g, 1, "fail high; new window %d/%d", alpha, beta);
+    }
+    else {
+      *score = sc;
+      break;
+    }
+  }
+  return moves;
+}
+
+/* Iterative deepening, shared by the ITERATIVE and MTDF AIs. Calls
+ * C<search> for each ply in turn until the time is up, and returns
+ * the best move found. C<search> is passed the moves in order of
+ * their score in the previous iteration, and that iteration's best
+ * score. */
+static GGTL_MOVE *deepen(GGTL *g, GGTL_MOVE *moves,
+                         GGTL_MOVE *(*search)(GGTL *, GGTL_MOVE *,
+                                              GGTL_MOVE **, int *))
+{
+  GGTL_MOVE *m, **order;
+  int i, ply, saved_ply, score = 0;
+  double start, elapsed, overshoot;
+
+  assert(1 < sl_count(moves));
+  saved_ply = ggtl_get(g, PLY);
+  start = g->started = setstarttime();
+
+  /* the root moves are re-ordered between iterations; remember
+   * the order they were generated in */
+  order = ggtl_alloc(g, sl_count(moves) * sizeof *order);
+  if (!order) {
+    ggtl_cache_moves(g, moves);
+    return NULL;
+  }
+  for (i = 0, m = moves; m; m = m->next) {
+    order[i++] = m;
+  }
+
+  if (ggtl_get(g, HARD_DEADLINE) && !g->pondering) {
+    g->deadline = start + g->time_to_search;
+  }
+  if (ggtl_get(g, ROOT_PARALLEL) && !g->fail_soft) {
+    g->root_parallel = 1;
+    smp_start(g, ai_worker);
+  }
+  else if (g->tt) {
+    smp_start(g, ai_helper);
+  }
+
+  for (ply = 1;; ply++) { 
+    ggtl_set(g, PLY, ply);
+
+    moves = search(g, moves, order, &score);
+    if (!moves || g->aborted) {
+      break;
+    }
+    g->opts[PLY_REACHED] = ply;
+    g->opts[SCORE] = score;
+
+    if (!ponder_hit(g)) {
+      if (ply >= PONDER_PLIES) {
+        break;
+      }
+      continue;
+    }
+    if (!havetimeleft(g->started, g->time_to_search / 2.0)) {
+      break;
+    }
+  }
+  smp_stop(g, g->root_parallel);
+  g->root_parallel = 0;
+  ggtl_set(g, PLY, saved_ply);
+  ggtl_dealloc(g, order);
+  g->deadline = 0;
+  g->aborted = 0;
+  g->pondering = 0;
+
+  elapsed = setstarttime() - start;
+  overshoot = setstarttime() - g->started - g->time_to_search;
+  if (overshoot > 0) {
+    g->opts[OVERSHOOT] = (int)(overshoot * 1000000);
+  }
+  if (elapsed > 0) {
+    g->opts[NPS] = (int)((g->opts[VISITED] + g->opts[QS_VISITED]) / elapsed);
+  }
+
+  m = sl_pop(&moves);
+  ggtl_cache_moves(g, moves);
+
+  return m;
+}
+
+GGTL_MOVE *ai_iterative(GGTL *g, GGTL_MOVE *moves)
+{
+  return deepen(g, moves, aspiration);
+}
+
+/* Make the move the player to move in C<g> is expected to make,
+ * for pondering: the best move stored in the transposition table,
+ * or else the best move found by a one-ply search. Returns the new
+ * state, or NULL if no move could be made. */
+GGTL_STATE *ai_predict(GGTL *g)
+{
+  GGTL_VTAB *v = ggtl_vtab(g);
+  GGTL_MOVE *moves, *m;
+  GGTL_STATE *state;
+  int i, sc, best = -1, saved_ply = ggtl_get(g, PLY);
+
+  moves = ggtl_get_moves(g);
+  if (!moves) {
+    return NULL;
+  }
+  if (g->tt && v->hash) {
+    (void)tt_probe(g, v->hash(ggtl_peek_state(g), g), TT_DEPTH_END,
+      GGTL_FITNESS_MIN-1, GGTL_FITNESS_MAX, &sc, &best);
+  }
+  if (best >= 0 && best < sl_count(moves)) {
+    GGTL_MOVE *prev = NULL;
+    for (i = 0, m = moves; i < best; i++, m = m->next) {
+      prev = m;
+    }
+    if (prev) {
+      prev->next = m->next;
+      m->next = moves;
+      moves = m;
+    }
+  }
+  else if (moves->next) {
+    ggtl_set(g, PLY, 1);
+    moves = search_root(g, moves, NULL, GGTL_FITNESS_MIN-1, 
+      GGTL_FITNESS_MAX, &sc);
+    ggtl_set(g, PLY, saved_ply);
+    if (!moves) {
+      return NULL;
+    }
+  }
+
+  m = sl_pop(&moves);
+  ggtl_cache_moves(g, moves);
+  state = ggtl_move_internal(g, m);
+  if (!state) {
+    ggtl_cache_moves(g, m);
+  }
+  return state;
+}
+
+/* The search made by helper thread number C<id> (counting from 1):
+ * iterative deepening with the full window until told to stop.
+ * Every other helper starts a ply deeper than the main thread, so
+ * the threads spread out over the iterations rather than all
+ * searching the same one. The moves are not used; only what the
+ * helper leaves in the shared transposition table matters. */
+void ai_helper(GGTL *g, int id)
+{
+  GGTL_MOVE *moves;
+  int ply, score;
+  double start, elapsed;
+
+  start = setstarttime();
+  moves = ggtl_get_moves(g);
+  for (ply = 1 + id % 2; moves && !timeout(g); ply++) {
+    ggtl_set(g, PLY, ply);
+    moves = search_root(g, moves, NULL, GGTL_FITNESS_MIN-1, 
+      GGTL_FITNESS_MAX, &score);
+    if (moves && !g->aborted) {
+      g->opts[PLY_REACHED] = ply;
+    }
+  }
+  ggtl_cache_moves(g, moves);
+  g->aborted = 0;
+
+  elapsed = setstarttime() - start;
+  if (elapsed > 0) {
+    g->opts[NPS] = (int)((g->opts[VISITED] + g->opts[QS_VISITED]) / elapsed);
+  }
+}
+
+/*
+
+=item PVS
+
+Performs a fixed-depth Principal Variation Search (also known as
+NegaScout) to the depth set with C<ggtl_set(g, PLY, depth)>. This
+finds the same moves as FIXED. The first move at each position is
+searched with the full Alpha-Beta window; the rest are searched
+with a null window to prove that they are no better, and only
+searched again with the full window if that fails. This only pays
+off when the best move tends to be searched first (e.g. with a
+transposition table; see C<TT_SIZE> in L<ggtl(3)|ggtl>); otherwise
+the searches made again can make PVS visit more states than FIXED.
+With the Reversi extension's move ordering it visits a few percent
+more in the opening, and only sometimes fewer at deeper plies.
+
+=cut
+
+*/
+
+GGTL_MOVE *ai_pvs(GGTL *g, GGTL_MOVE *moves)
+{
+  GGTL_MOVE *best;
+
+  g->pvs = 1;
+  best = ai_fixed(g, moves);
+  g->pvs = 0;
+
+  return best;
+}
+
+/*
+
+=item MTDF
+
+Performs an iterative deepening MTD(f) search. Rather than
+searching each iteration once with a wide Alpha-Beta window, it
+is searched several times with a null window, each search telling
+whether the score is above or below a guess. Starting with the
+score from the previous iteration, the guess is adjusted until it
+is known to be the score of the best move.
+
+The same positions are searched over and over, so MTD(f) is only
+worthwhile with a transposition table. It requires the C<hash()>
+callback (see L<ggtlcb(3)|ggtlcb>); without it the ITERATIVE AI
+is used instead. If C<TT_SIZE> has not been set, a table with
+65536 entries is allocated. The time limit works as for the
+ITERATIVE AI. The score of the move picked is the same as that of
+the move FIXED picks at the depth reached, but if several moves
+have the same score, a different one may be picked.
+
+=cut
+
+*/
+
+/* Zero in on the score of the best root move at the current PLY,
+ * starting from the guess C<score>. The moves are returned with
+ * the best at the head, or NULL on error. */
+static GGTL_MOVE *mtdf(GGTL *g, GGTL_MOVE *moves, GGTL_MOVE **order,
+                       int *score)
+{
+  GGTL_MOVE *best = moves;
+  int lower = GGTL_FITNESS_MIN-1;
+  int upper = GGTL_FITNESS_MAX;
+  int f = *score;
+
+  while (lower < upper) {
+    int sc, beta = f == lower ? f + 1 : f;
+
+    moves = search_root(g, moves, order, beta - 1, beta, &sc);
+    if (moves && sc >= beta) {
+      best = moves;     /* the move that failed high */
+    }
+    if (!moves || g->aborted) {
+      break;
+    }
+
+    f = sc;
+    if (f < beta) {
+      upper = f;
+    }
+    else {
+      lower = f;
+    }
+    ai_trace(g, 1, "bounds: %d/%d", lower, upper);
+  }
+
+  if (moves && moves != best) {
+    GGTL_MOVE *m;
+    for (m = moves; m->next != best; m = m->next)
+      ;
+    m->next = best->next;
+    best->next = moves;
+    moves = best;
+  }
+  *score = f;
+  return moves;
+}
+
+GGTL_MOVE *ai_mtdf(GGTL *g, GGTL_MOVE *moves)
+{
+  GGTL_MOVE *best;
+
+  if (!g->vtab->hash) {
+    ai_trace(g, 1, "no hash() callback; using ITERATIVE");
+    return ai_iterative(g, moves);
+  }
+  if (!g->tt) {
+    ggtl_set(g, TT_SIZE, 65536);
+  }
+
+  g->fail_soft = 1;
+  best = deepen(g, moves, mtdf);
+  g->fail_soft = 0;
+
+  return best;
+}
+
+/*
+
+=item YBWC
+
+A fixed-depth Alpha-Beta search, like FIXED, that is split among
+C<THREADS> threads using the "Young Brothers Wait" concept. At
+each position the first move is searched alone; if it does not
+cause a cutoff, the rest of the moves are shared among the
+threads, which search them at the same time. If one of them
+causes a cutoff, the searches of the others are aborted.
+
+Only the thread that called C<ggtl_ai_move()> splits positions,
+and only one position at a time, so the helper threads sit idle
+while it searches the first move of a position. The root moves
+are searched one after the other, with the positions below them
+split; the move picked is the same as that of FIXED unless a
+transposition table is used. The helper threads require the
+C<clone_state()> callback; without it, or if C<THREADS> is 1 (the
+default), this is the same as FIXED.
+
+C<VISITED>, C<QS_VISITED> and the other counts include the work
+of all the threads, so comparing them with those of FIXED shows
+how much extra work splitting costs. Use C<ggtl_get_thread()> (see
+L<ggtl(3)|ggtl>) to see how it was shared among the threads.
+
+=cut
+
+*/
+
+/* The helper threads of YBWC: search moves at the split point of
+ * the instance helped, if any, until told to stop */
+void ai_worker(GGTL *g, int id)
+{
+  GGTL *owner = g->master;
+
+  (void)id;
+  smp_lock(owner);
+  while (!owner->smp_stop) {
+    if (!owner->split || !split_work(g, owner, owner->split)) {
+      smp_wait(owner);
+    }
+  }
+  smp_unlock(owner);
+}
+
+GGTL_MOVE *ai_ybwc(GGTL *g, GGTL_MOVE *moves)
+{
+  GGTL_MOVE *best;
+
+  g->ybwc = 1;
+  smp_start(g, ai_worker);
+  best = ai_fixed(g, moves);
+  smp_stop(g, 1);
+  g->ybwc = 0;
+
+  return best;
+}
+
+/* The incremental search of ggtl_search_begin() and friends: the
+ * iterative deepening search of ITERATIVE (see deepen() and
+ * aspiration()), done a bounded number of states at a time. Each
+ * root move is searched by ab() with a node limit. A step that runs
+ * out of states takes back the moves on the path to the top frame,
+ * and the next step makes them again and carries on from there. */
+struct ggtl_inc {
+  GGTL_MOVE *todo;      /* root moves left to search this pass */
+  GGTL_MOVE *done;      /* root moves searched this pass */
+  GGTL_MOVE **order;    /* the root moves in the order generated */
+  GGTL_MOVE *best;      /* best move of this pass so far */
+  GGTL_MOVE *result;    /* best move of the last complete iteration */
+  GGTL_MOVE *current;   /* root move being searched, between steps */
+  int besti, alpha, top, pos;
+  int curi, tie;
+  int lo, beta, width;  /* the window of this pass */
+  int score;            /* score of the last complete iteration */
+  int ply, maxply;
+  int nmoves;
+  int in_probcut;       /* g->in_probcut, between steps */
+};
+
+/* Set the window for the first pass of iteration C<s->ply>, as
+ * aspiration() does */
+static void inc_window(GGTL *g, struct ggtl_inc *s)
+{
+  s->lo = GGTL_FITNESS_MIN-1;
+  s->beta = GGTL_FITNESS_MAX;
+  s->width = ggtl_get(g, ASPIRATION);
+  if (s->width > 0 && s->ply > 1) {
+    s->lo = widen(s->score, s->width, s->lo);
+    s->beta = widen(s->score, s->width, s->beta);
+  }
+}
+
+/* Start a pass over the root moves C<moves> */
+static void inc_pass(struct ggtl_inc *s, GGTL_MOVE *moves)
+{
+  s->todo = moves;
+  s->done = s->best = NULL;
+  s->besti = s->pos = 0;
+  s->alpha = s->lo;
+  s->top = GGTL_FITNESS_MIN-1;
+}
+
+/* Start an incremental search of C<moves>. Returns false on error,
+ * in which case the moves are cached. */
+int ai_begin(GGTL *g, GGTL_MOVE *moves)
+{
+  struct ggtl_inc *s;
+  GGTL_MOVE *m;
+  int i;
+
+  s = ggtl_alloc(g, sizeof *s);
+  if (s) {
+    s->order = ggtl_alloc(g, sl_count(moves) * sizeof *s->order);
+  }
+  if (!s || !s->order) {
+    ggtl_dealloc(g, s);
+    ggtl_cache_moves(g, moves);
+    return 0;
+  }
+  for (i = 0, m = moves; m; m = m->next) {
+    s->order[i++] = m;
+  }
+  s->nmoves = i;
+  s->result = moves;
+  s->current = NULL;
+  s->score = 0;
+  s->ply = 1;
+  s->maxply = ggtl_get(g, PLY);
+  s->in_probcut = 0;
+  inc_window(g, s);
+  inc_pass(s, moves);
+  g->inc = s;
+
+  if (!g->tt && g->vtab->hash) {
+    ggtl_set(g, TT_SIZE, 65536);
+  }
+  return 1;
+}
+
+/* Take back what frame C<f> has made: its move, or a null move */
+static void frame_undo(GGTL *g, struct ggtl_frame *f)
+{
+  if (f->phase == F_NULL) {
+    (void)ggtl_vtab(g)->null_unmove(ggtl_peek_state(g), g);
+  }
+  else if (f->phase >= F_LMR && !f->base) {
+    (void)ggtl_undo_internal(g);
+  }
+}
+
+/* Make again what frame C<f> had made. Returns false on error. */
+static int frame_redo(GGTL *g, struct ggtl_frame *f)
+{
+  if (f->phase == F_NULL) {
+    return ggtl_vtab(g)->null_move(ggtl_peek_state(g), g) != NULL;
+  }
+  if (f->phase >= F_LMR && !f->base) {
+    return ggtl_move_internal(g, f->move) != NULL;
+  }
+  return 1;
+}
+
+/* Take back the moves on the path to the top frame and the current
+ * root move, which stay in their frames for inc_redo() */
+static void inc_undo(GGTL *g, struct ggtl_inc *s)
+{
+  int i;
+
+  for (i = g->frame_depth; i-- > 0; ) {
+    frame_undo(g, g->frames + i);
+  }
+  s->current = ggtl_undo_internal(g);
+  s->in_probcut = g->in_probcut;
+  g->in_probcut = 0;
+}
+
+/* Make the moves taken back by inc_undo() again. Returns false on
+ * error, in which case none of them are made. */
+static int inc_redo(GGTL *g, struct ggtl_inc *s)
+{
+  int i;
+
+  if (!ggtl_move_internal(g, s->current)) {
+    return 0;
+  }
+  for (i = 0; i < g->frame_depth; i++) {
+    if (!frame_redo(g, g->frames + i)) {
+      while (i-- > 0) {
+        frame_undo(g, g->frames + i);
+      }
+      (void)ggtl_undo_internal(g);
+      return 0;
+    }
+  }
+  g->in_probcut = s->in_probcut;
+  return 1;
+}
+
+/* Search at most C<nodes> more states. Returns 1 if the search is
+ * complete, 0 if there is more to do, or -1 on error. */
+int ai_step(GGTL *g, int nodes)
+{
+  struct ggtl_inc *s = g->inc;
+  GGTL_MOVE *m;
+  int ret = 1;
+
+  assert(s != NULL);
+  g->node_limit = g->opts[VISITED] + g->opts[QS_VISITED] + nodes;
+
+  /* with only one move, there is nothing to search */
+  while (s->ply <= s->maxply && s->nmoves > 1) {
+    int sc = 0;
+
+    ggtl_set(g, PLY, s->ply);
+
+    /* the root moves are searched as by search_root(); with a full
+     * window, keep going after a win to find ties */
+    while ((s->alpha < s->beta || s->beta == GGTL_FITNESS_MAX)
+           && (s->current || s->todo)) {
+      int r = 1;
+
+      if (s->current) {
+        if (!inc_redo(g, s)) {
+          ret = -1;
+          goto out;
+        }
+        r = ab(g, A_ENTER, &sc);
+      }
+      else {
+        struct ggtl_frame *f;
+
+        if (g->opts[VISITED] + g->opts[QS_VISITED] >= g->node_limit) {
+          ret = 0;
+          goto out;
+        }
+        m = sl_pop(&s->todo);
+        if (!ggtl_move_internal(g, m)) {
+          s->todo = sl_push(s->todo, m);
+          ret = -1;
+          goto out;
+        }
+        s->current = m;
+        s->curi = root_index(s->order, m, s->pos);
+        s->tie = s->best && s->curi < s->besti;
+        f = base_push(g, s->alpha - s->tie, s->beta, s->ply, s->best != NULL);
+        if (f) {
+          r = ab(g, search_pvs(g, f), &sc);
+        }
+      }
+      if (!r) {
+        inc_undo(g, s);
+        ret = 0;
+        goto out;
+      }
+
+      m = ggtl_undo_internal(g);
+      assert(m == s->current);
+      s->current = NULL;
+      if (g->aborted) {
+        /* there was no room for a frame */
+        s->todo = sl_push(s->todo, m);
+        g->aborted = 0;
+        ret = -1;
+        goto out;
+      }
+      ai_trace(g, 2, "a/b: %d/%d (visited: %d)", sc, s->beta,
+        ggtl_get(g, VISITED));
+      m->fitness = sc;
+      if (sc > s->top) {
+        s->top = sc;
+      }
+      if (sc > s->alpha || (s->tie && sc == s->alpha)) {
+        s->best = m;
+        s->besti = s->curi;
+        s->alpha = sc;
+      }
+      s->done = sl_push(s->done, m);
+      s->pos++;
+    }
+
+    /* the pass is complete */
+    sc = g->fail_soft && !s->best ? s->top : s->alpha;
+    while ((m = sl_pop(&s->todo))) {
+      s->done = sl_push(s->done, m);
+    }
+    m = root_sort(g, s->done, s->best, NULL, s->alpha);
+
+    if (sc <= s->lo && s->lo > GGTL_FITNESS_MIN-1) {
+      s->width = grow(s->width, ggtl_get(g, ASP_GROWTH));
+      s->lo = widen(s->score, s->width, GGTL_FITNESS_MIN-1);
+      ai_trace(g, 1, "fail low; new window %d/%d", s->lo, s->beta);
+    }
+    else if (sc >= s->beta && s->beta < GGTL_FITNESS_MAX) {
+      s->width = grow(s->width, ggtl_get(g, ASP_GROWTH));
+      s->beta = widen(s->score, s->width, GGTL_FITNESS_MAX);
+      ai_trace(g, 1, "fail high; new window %d/%d", s->lo, s->beta);
+    }
+    else {
+      /* the iteration is complete */
+      s->result = m;
+      s->score = sc;
+      g->opts[PLY_REACHED] = s->ply;
+      g->opts[SCORE] = sc;
+      s->ply++;
+      inc_window(g, s);
+    }
+    inc_pass(s, m);
+  }
+
+out:
+  ggtl_set(g, PLY, s->maxply);
+  g->node_limit = 0;
+  return ret;
+}
+
+/* Returns the best move found by the incremental search so far. */
+GGTL_MOVE *ai_result(GGTL *g)
+{
+  assert(g->inc != NULL);
+  return g->inc->result;
+}
+
+/* End the incremental search. Returns the best move found, or NULL
+ * if C<best> is false; the other moves are cached. */
+GGTL_MOVE *ai_end(GGTL *g, int best)
+{
+  struct ggtl_inc *s = g->inc;
+  GGTL_MOVE *m, *result = NULL;
+
+  if (!s) {
+    return NULL;
+  }
+
+  /* throw away the frames of a root move's search; their moves
+   * have been taken back */
+  while (g->frame_depth > 0) {
+    struct ggtl_frame *f = TOP(g);
+    if (!f->base) {
+      ply_release(g, f->moves, f->array);
+      if (!f->array && f->move) {
+        ggtl_cache_moves(g, f->move);
+      }
+    }
+    g->frame_depth--;
+  }
+  if (s->current) {
+    s->todo = sl_push(s->todo, s->current);
+  }
+  while ((m = sl_pop(&s->done))) {
+    s->todo = sl_push(s->todo, m);
+  }
+  while ((m = sl_pop(&s->todo))) {
+    if (best && m == s->result) {
+      result = m;
+    }
+    else {
+      ggtl_cache_moves(g, m);
+    }
+  }
+  ggtl_dealloc(g, s->order);
+  ggtl_dealloc(g, s);
+  g->inc = NULL;
+  return result;
+}
+
+/* Search the current state, which is the position after a root
+ * move of a coordinator's search to C<ply>, for ggtl_serve().
+ * Returns the score from the point of view of the player that
+ * made the move, or GGTL_ERR on error. */
+int ai_serve(GGTL *g, int ply, int plytogo, int alpha, int beta)
+{
+  int sc, saved_ply = ggtl_get(g, PLY);
+
+  ggtl_set(g, PLY, ply);
+  g->aborted = 0;
+  sc = pvs(g, alpha, beta, plytogo, 0);
+  ggtl_set(g, PLY, saved_ply);
+  return sc == -GGTL_ERR ? GGTL_ERR : sc;
 }
 
 /*
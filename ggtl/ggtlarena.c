@@ -0,0 +1,270 @@
+/*
+GGTL - 2-player strategic games AI.
+Copyright (C) 2005-2006 Stig Brautaset. All rights reserved.
+
+This file is part of GGTL.
+
+GGTL is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+GGTL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GGTL; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/*
+
+=begin internal
+
+Arena for the C<GGTL_STATE> and C<GGTL_MOVE> nodes needed during a
+search. If the C<ARENA> option is set, C<ggtl_ai_move()> hands out
+nodes from slabs by bumping a pointer, instead of allocating each
+node its caches can't provide. The first slab has room for C<ARENA>
+nodes, and each one after that for twice as many as the last.
+
+Nodes of the arena are never freed on their own. During a search
+they go round the caches like any other node, and when the caches
+are freed, the empty ones are put on a list of spare nodes, which
+arena_node() hands out again before bumping the pointer.
+
+When the search is over, the move made is copied out of the arena,
+and so are the empty nodes in the caches. Every slab but the first
+all of whose nodes are then spare is freed, and if all the nodes
+of the newest slab left are spare, the pointer is moved back to its
+start. So without the cache the arena is reset after every search;
+with it, the slabs kept are those with nodes that are still cached.
+
+The arena is not used when C<THREADS> is above 1. Nodes already
+handed out can still turn up in the caches then, which is fine as
+each GGTL structure's caches are only used by its own thread.
+
+=end internal
+
+=cut
+
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <sl/sl.h>
+
+#include "core.h"
+#include "private.h"
+
+/* Returns a new slab of C<size> nodes, or NULL on error */
+static struct ggtl_slab *slab_new(GGTL *g, int size)
+{
+  struct ggtl_slab *s;
+
+  s = ggtl_alloc(g, sizeof *s + (size - 1) * sizeof s->nodes[0]);
+  if (s) {
+    s->next = NULL;
+    s->size = size;
+    s->spare = 0;
+  }
+  return s;
+}
+
+/* Get ready for a search */
+void arena_start(GGTL *g)
+{
+  g->arena_on = ggtl_get(g, ARENA) > 0 && ggtl_get(g, THREADS) <= 1;
+}
+
+/* Returns a node from the arena, big enough for a C<GGTL_STATE> or
+ * a C<GGTL_MOVE>, or NULL if the arena is not in use or there is no
+ * memory for another slab. */
+void *arena_node(GGTL *g)
+{
+  struct ggtl_slab *s = g->slabs;
+  union ggtl_node *n;
+
+  if (!g->arena_on) {
+    return NULL;
+  }
+
+  n = sl_pop(&g->spare);
+  if (!n) {
+    if (!s || g->slab_used == s->size) {
+      s = slab_new(g, s ? 2 * s->size : ggtl_get(g, ARENA));
+      if (!s) {
+        return NULL;
+      }
+      g->slabs = sl_push(g->slabs, s);
+      g->slab_used = 0;
+    }
+    n = s->nodes + g->slab_used++;
+  }
+  n->m.next = NULL;
+  n->m.fitness = 0;
+  n->m.data = NULL;
+  return n;
+}
+
+/* Returns the slab C<node> was handed out from, or NULL if it is not
+ * in the arena. The newest slabs are the biggest, so they are looked
+ * at first. */
+static struct ggtl_slab *slab_of(GGTL *g, void *node)
+{
+  struct ggtl_slab *s;
+  union ggtl_node *n = node;
+
+  for (s = g->slabs; s; s = s->next) {
+    if (n >= s->nodes && n < s->nodes + s->size) {
+      return s;
+    }
+  }
+  return NULL;
+}
+
+/* Returns true if C<node> was handed out by arena_node() */
+int arena_owns(GGTL *g, void *node)
+{
+  return slab_of(g, node) != NULL;
+}
+
+/* Puts the empty node C<n> on the list of spare nodes if it is in
+ * the arena; returns false if it is not */
+int arena_spare(GGTL *g, void *n)
+{
+  if (!arena_owns(g, n)) {
+    return 0;
+  }
+  g->spare = sl_push(g->spare, n);
+  return 1;
+}
+
+/* Puts the nodes of the arena on the list of empty nodes C<list> on
+ * the list of spare nodes, and returns what is left */
+static void *drop_empty(GGTL *g, void *list)
+{
+  void *kept = NULL, *n;
+
+  while ((n = sl_pop(&list))) {
+    if (!arena_spare(g, n)) {
+      kept = sl_push(kept, n);
+    }
+  }
+  return sl_reverse(kept);
+}
+
+/* Returns C<n> copied to a node of its own if it is in the arena, or
+ * NULL if there is no memory for that (and the move is freed) */
+static GGTL_MOVE *keep_move(GGTL *g, GGTL_MOVE *n)
+{
+  GGTL_MOVE *c;
+
+  if (!arena_owns(g, n)) {
+    return n;
+  }
+  if (n->data == n->packed.c) {
+    c = ggtl_wrap_move(g, NULL);
+    if (c) {
+      c->packed = n->packed;
+      c->data = c->packed.c;
+    }
+  }
+  else {
+    c = ggtl_wrap_move(g, n->data);
+    if (!c) {
+      move_release(g, n->data);
+    }
+  }
+  if (c) {
+    c->fitness = n->fitness;
+  }
+  n->data = NULL;
+  g->spare = sl_push(g->spare, n);
+  return c;
+}
+
+/* Frees the slabs (but the first) all of whose nodes are spare, and
+ * moves the pointer back to the start of the newest slab left if all
+ * of its nodes are. The count of spare nodes of a slab is set to -1
+ * if it is to be freed, and to -2 if it is to be reset. */
+static void trim(GGTL *g)
+{
+  struct ggtl_slab *s, *newest = NULL, *kept = NULL;
+  union ggtl_node *n;
+  void *spare = NULL;
+  int used = g->slab_used;
+
+  for (s = g->slabs; s; s = s->next) {
+    s->spare = 0;
+  }
+  for (n = g->spare; n; n = (void *)n->m.next) {
+    slab_of(g, n)->spare++;
+  }
+
+  /* only slab_used nodes have been handed out from the newest */
+  for (s = g->slabs; s; s = s->next) {
+    int handed = s == g->slabs ? g->slab_used : s->size;
+    if (s->next && s->spare == handed) {
+      s->spare = -1;
+    }
+    else if (!newest) {
+      newest = s;
+      used = handed;
+      if (s->spare == handed) {
+        s->spare = -2;
+        used = 0;
+      }
+    }
+  }
+
+  while ((n = sl_pop(&g->spare))) {
+    if (slab_of(g, n)->spare >= 0) {
+      spare = sl_push(spare, n);
+    }
+  }
+  g->spare = spare;
+
+  while ((s = sl_pop(&g->slabs))) {
+    if (s->spare == -1) {
+      ggtl_dealloc(g, s);
+    }
+    else {
+      kept = sl_push(kept, s);
+    }
+  }
+  g->slabs = sl_reverse(kept);
+  g->slab_used = used;
+}
+
+/* The search is over; nodes are no longer handed out. Returns
+ * C<move> (the move found by the search, or NULL) moved out of the
+ * arena, or NULL if there was no memory for that. */
+GGTL_MOVE *arena_stop(GGTL *g, GGTL_MOVE *move)
+{
+  g->arena_on = 0;
+  if (!g->slabs) {
+    return move;
+  }
+  g->sc_cache = drop_empty(g, g->sc_cache);
+  g->mc_cache = drop_empty(g, g->mc_cache);
+  if (move) {
+    move = keep_move(g, move);
+  }
+  trim(g);
+  return move;
+}
+
+void arena_free(GGTL *g)
+{
+  struct ggtl_slab *s;
+
+  assert(!g->arena_on);
+  while ((s = sl_pop(&g->slabs))) {
+    ggtl_dealloc(g, s);
+  }
+  g->spare = NULL;
+  g->slab_used = 0;
+}
@@ -0,0 +1,621 @@
+/*
+GGTL - 2-player strategic games AI.
+Copyright (C) 2005-2006 Stig Brautaset. All rights reserved.
+
+This file is part of GGTL.
+
+GGTL is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+GGTL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GGTL; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#if 0 /* C comments don't nest */
+
+=head1 NAME
+
+ggtlnet - share a search among several processes
+
+=head1 SYNOPSIS
+
+  #include <ggtl/core.h>
+
+  /* a worker process */
+  GGTL *w = reversi_init(ggtl_new(), NULL);
+  int l = ggtl_listen("unix:/tmp/reversi.sock");
+  for (;;) {
+    int fd = accept(l, NULL, NULL);
+    ggtl_serve(w, fd);
+    close(fd);
+  }
+
+  /* the coordinator */
+  ggtl_add_worker(g, ggtl_connect("unix:/tmp/reversi.sock"));
+  ggtl_add_worker(g, ggtl_connect("otherhost:4711"));
+  ggtl_ai_move(g);
+
+=head1 DESCRIPTION
+
+A GGTL structure can hand the moves at the root of its searches
+to worker processes, on the same machine or on others, which
+search them and send back their scores. Each worker has its own
+memory (and transposition table), so this scales past what one
+process can hold.
+
+The workers and the coordinator talk over Unix domain or TCP
+sockets. Positions are sent in the compact form produced by the
+C<serialize()> callback, and read by the workers with the
+C<deserialize()> callback; see L<ggtlcb(3)|ggtlcb>. Moves are
+never sent: the coordinator makes each root move itself and sends
+the position after it.
+
+The moves are shared out as by the C<ROOT_PARALLEL> option (see
+L<ggtl(3)|ggtl>), so the same move is picked as by a search in one
+process. Only the FIXED and ITERATIVE AIs use the workers. A
+worker searches with its own options (C<TT_SIZE>, C<KILLERS> and
+so on); only the depth and window are sent. The counts of states
+visited and so on by the workers are added to those of the
+coordinator.
+
+If a worker fails, the move it was searching is searched by the
+coordinator, and the worker is not used again. A search on a
+worker cannot be aborted, so with C<HARD_DEADLINE> set a search
+can go past its deadline by as much as the time to search one
+root move.
+
+There is no authentication, and workers trust what they are sent
+(and the coordinator what it gets back). Only listen on sockets
+that untrusted parties cannot reach.
+
+=head1 FUNCTIONS
+
+=over
+
+=cut
+
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+#include "private.h"
+
+#if HAVE_SYS_SOCKET_H && HAVE_SYS_UN_H && HAVE_NETDB_H && HAVE_POLL_H
+#include <errno.h>
+#include <netdb.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#define HAVE_SOCKETS 1
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+#endif
+
+/* Requests are a 4-byte length (of what follows) and a NET_QUIT or
+ * NET_SEARCH opcode. A search request goes on with the ply of the
+ * coordinator's search, the plies left to search, alpha and beta,
+ * followed by the serialized state. The reply is the score and the
+ * counts in net_keys. Numbers are 4 bytes, most significant first. */
+enum { NET_QUIT = 0, NET_SEARCH };
+
+#define NET_HEADER 17           /* opcode, ply, plytogo, alpha, beta */
+#define NET_MAX_STATE (1 << 20) /* largest serialized state accepted */
+
+#if HAVE_SOCKETS
+static const int net_keys[] = {
+  VISITED, TT_HITS, TT_MISSES, CUTOFFS, FIRST_CUTOFFS, QS_VISITED,
+  NULL_CUTOFFS, LMR_REDUCED, FUTILITY_PRUNED, PROBCUT_CUTS,
+  TT_SHARED_HITS
+};
+#define NET_KEYS (sizeof net_keys / sizeof net_keys[0])
+#define NET_REPLY (4 + 4 * NET_KEYS)
+
+static void put32(unsigned char *p, long v)
+{
+  unsigned long u = (unsigned long)v;
+  p[0] = (u >> 24) & 0xff;
+  p[1] = (u >> 16) & 0xff;
+  p[2] = (u >> 8) & 0xff;
+  p[3] = u & 0xff;
+}
+
+static long get32(const unsigned char *p)
+{
+  unsigned long u = (unsigned long)p[0] << 24 | (unsigned long)p[1] << 16
+    | (unsigned long)p[2] << 8 | p[3];
+  return u & 0x80000000UL ? -(long)(0xffffffffUL - u) - 1 : (long)u;
+}
+
+/* Write or read all C<n> bytes of C<buf>. Return 1 on success, or
+ * 0 on error or end of file. */
+static int net_write(int fd, const unsigned char *buf, size_t n)
+{
+  while (n) {
+    ssize_t r = send(fd, buf, n, MSG_NOSIGNAL);
+    if (r < 0 && errno == EINTR) {
+      continue;
+    }
+    if (r <= 0) {
+      return 0;
+    }
+    buf += r;
+    n -= r;
+  }
+  return 1;
+}
+
+static int net_read(int fd, unsigned char *buf, size_t n)
+{
+  while (n) {
+    ssize_t r = recv(fd, buf, n, 0);
+    if (r < 0 && errno == EINTR) {
+      continue;
+    }
+    if (r <= 0) {
+      return 0;
+    }
+    buf += r;
+    n -= r;
+  }
+  return 1;
+}
+
+static void net_close(struct ggtl_worker *w)
+{
+  close(w->fd);
+  w->fd = -1;
+}
+
+/* Open a socket for ggtl_listen() or ggtl_connect() */
+static int net_open(const char *addr, int listening)
+{
+  struct addrinfo hints, *res, *ai;
+  char host[256];
+  const char *port;
+  int fd = -1;
+
+  if (!strncmp(addr, "unix:", 5)) {
+    struct sockaddr_un un;
+
+    if (strlen(addr + 5) >= sizeof un.sun_path) {
+      return -1;
+    }
+    memset(&un, 0, sizeof un);
+    un.sun_family = AF_UNIX;
+    strcpy(un.sun_path, addr + 5);
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+      return -1;
+    }
+    if (listening
+        ? bind(fd, (struct sockaddr *)&un, sizeof un) || listen(fd, 16)
+        : connect(fd, (struct sockaddr *)&un, sizeof un)) {
+      close(fd);
+      return -1;
+    }
+    return fd;
+  }
+
+  port = strrchr(addr, ':');
+  if (!port || (size_t)(port - addr) >= sizeof host) {
+    return -1;
+  }
+  memcpy(host, addr, port - addr);
+  host[port - addr] = '\0';
+  port++;
+
+  memset(&hints, 0, sizeof hints);
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  hints.ai_flags = listening ? AI_PASSIVE : 0;
+  if (getaddrinfo(*host ? host : NULL, port, &hints, &res)) {
+    return -1;
+  }
+  for (ai = res; ai; ai = ai->ai_next) {
+    int on = 1;
+
+    fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (fd < 0) {
+      continue;
+    }
+    if (listening) {
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof on);
+      if (!bind(fd, ai->ai_addr, ai->ai_addrlen) && !listen(fd, 16)) {
+        break;
+      }
+    }
+    else if (!connect(fd, ai->ai_addr, ai->ai_addrlen)) {
+      break;
+    }
+    close(fd);
+    fd = -1;
+  }
+  freeaddrinfo(res);
+  return fd;
+}
+
+/* Search the serialized state in C<buf> for ggtl_serve(), and put
+ * the counts of the search in C<counts>. */
+static int net_search(GGTL *g, const unsigned char *buf, int n, int ply,
+                      int plytogo, int alpha, int beta, long *counts)
+{
+  GGTL_STATE *saved = g->states;
+  void *s;
+  int sc;
+  unsigned i;
+
+  if (!g->vtab->deserialize || plytogo < 0 || plytogo >= ply) {
+    return GGTL_ERR;
+  }
+  s = g->vtab->deserialize(buf, n, g);
+  if (!s) {
+    return GGTL_ERR;
+  }
+  g->states = ggtl_wrap_state(g, s);
+  if (!g->states) {
+    state_release(g, s);
+    g->states = saved;
+    return GGTL_ERR;
+  }
+
+  for (i = 0; i < NET_KEYS; i++) {
+    counts[i] = -g->opts[net_keys[i]];
+  }
+  sc = ai_serve(g, ply, plytogo, alpha, beta);
+  for (i = 0; i < NET_KEYS; i++) {
+    counts[i] += g->opts[net_keys[i]];
+  }
+
+  ggtl_cache_states(g, g->states);
+  g->states = saved;
+  return sc;
+}
+#endif /* HAVE_SOCKETS */
+
+/*
+
+=item int ggtl_listen( const char *addr )
+
+=item int ggtl_connect( const char *addr )
+
+Return a socket listening on, or connected to, C<addr>, or -1 on
+failure. The address is either C<unix:> followed by the path of a
+Unix domain socket, or a host name or number, a colon, and a TCP
+port. To listen on all interfaces, leave out the host (as in
+C<:4711>). A Unix domain socket is not removed when it is closed,
+and C<ggtl_listen()> fails if the path already exists.
+
+=cut
+
+*/
+
+int ggtl_listen(const char *addr)
+{
+#if HAVE_SOCKETS
+  return net_open(addr, 1);
+#else
+  (void)addr;
+  return -1;
+#endif
+}
+
+int ggtl_connect(const char *addr)
+{
+#if HAVE_SOCKETS
+  return net_open(addr, 0);
+#else
+  (void)addr;
+  return -1;
+#endif
+}
+
+/*
+
+=item int ggtl_serve( *g, int fd )
+
+Work for the coordinator at the other end of the socket C<fd>
+until it is done with C<g> (or closes the connection), using the
+callbacks and options of C<g>. The socket is not closed. Returns
+the number of moves searched, or -1 on error.
+
+=cut
+
+*/
+
+int ggtl_serve(GGTL *g, int fd)
+{
+#if HAVE_SOCKETS
+  unsigned char head[4 + NET_HEADER], reply[NET_REPLY];
+  unsigned char *buf = NULL;
+  long counts[NET_KEYS];
+  int jobs = 0;
+
+  assert(g != NULL);
+
+  for (;;) {
+    long len;
+    int sc;
+    unsigned i;
+
+    if (!net_read(fd, head, 5)) {
+      break;
+    }
+    len = get32(head);
+    if (head[4] == NET_QUIT && len == 1) {
+      break;
+    }
+    if (head[4] != NET_SEARCH || len < NET_HEADER
+        || len - NET_HEADER > NET_MAX_STATE
+        || !net_read(fd, head + 5, NET_HEADER - 1)) {
+      jobs = -1;
+      break;
+    }
+    len -= NET_HEADER;
+
+    ggtl_dealloc(g, buf);
+    buf = ggtl_alloc(g, len ? len : 1);
+    if (!buf || !net_read(fd, buf, len)) {
+      jobs = -1;
+      break;
+    }
+
+    memset(counts, 0, sizeof counts);
+    sc = net_search(g, buf, len, get32(head + 5), get32(head + 9),
+                    get32(head + 13), get32(head + 17), counts);
+
+    put32(reply, sc);
+    for (i = 0; i < NET_KEYS; i++) {
+      put32(reply + 4 + 4 * i, counts[i]);
+    }
+    if (!net_write(fd, reply, sizeof reply)) {
+      jobs = -1;
+      break;
+    }
+    jobs++;
+  }
+
+  ggtl_dealloc(g, buf);
+  return jobs;
+#else
+  (void)g;
+  (void)fd;
+  return -1;
+#endif
+}
+
+/*
+
+=item int ggtl_add_worker( *g, int fd )
+
+Add the worker at the other end of the socket C<fd> (such as one
+returned by C<ggtl_connect()>) to those C<g> shares its searches
+with. C<g> takes over the socket, and closes it when it is freed.
+Returns 1 on success, or 0 on failure.
+
+Workers are used only if C<g> has the C<serialize()> callback.
+
+=cut
+
+*/
+
+int ggtl_add_worker(GGTL *g, int fd)
+{
+#if HAVE_SOCKETS
+  struct ggtl_worker *w;
+
+  assert(g != NULL);
+  if (fd < 0) {
+    return 0;
+  }
+  w = mem_realloc(g, g->workers, g->nworkers * sizeof *w,
+                  (g->nworkers + 1) * sizeof *w);
+  if (!w) {
+    return 0;
+  }
+  g->workers = w;
+  w += g->nworkers++;
+  w->fd = fd;
+  w->m = NULL;
+  w->pos = 0;
+  return 1;
+#else
+  (void)g;
+  (void)fd;
+  return 0;
+#endif
+}
+
+/* Returns a worker that is not searching anything, or NULL if
+ * there are none. */
+struct ggtl_worker *net_idle(GGTL *g)
+{
+  int i;
+
+  for (i = 0; i < g->nworkers; i++) {
+    if (g->workers[i].fd >= 0 && !g->workers[i].m) {
+      return g->workers + i;
+    }
+  }
+  return NULL;
+}
+
+/* Returns 1 if any worker is searching, 0 otherwise. */
+int net_busy(GGTL *g)
+{
+  int i;
+
+  for (i = 0; i < g->nworkers; i++) {
+    if (g->workers[i].m) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/* Ask worker C<w> to search the current state. Returns 1 on success,
+ * or 0 on failure; if the worker failed, it is not used again. */
+int net_send(GGTL *g, struct ggtl_worker *w, int ply, int plytogo,
+             int alpha, int beta)
+{
+#if HAVE_SOCKETS
+  unsigned char local[256], *buf = local;
+  void *s = ggtl_peek_state(g);
+  int n, ok;
+
+  n = g->vtab->serialize(s, buf + 4 + NET_HEADER,
+                         sizeof local - 4 - NET_HEADER, g);
+  if (n > (int)(sizeof local - 4 - NET_HEADER) && n <= NET_MAX_STATE) {
+    buf = ggtl_alloc(g, 4 + NET_HEADER + n);
+    if (!buf || g->vtab->serialize(s, buf + 4 + NET_HEADER, n, g) != n) {
+      ggtl_dealloc(g, buf);
+      return 0;
+    }
+  }
+  if (n < 0 || n > NET_MAX_STATE) {
+    return 0;
+  }
+
+  put32(buf, NET_HEADER + n);
+  buf[4] = NET_SEARCH;
+  put32(buf + 5, ply);
+  put32(buf + 9, plytogo);
+  put32(buf + 13, alpha);
+  put32(buf + 17, beta);
+
+  ok = net_write(w->fd, buf, 4 + NET_HEADER + n);
+  if (!ok) {
+    net_close(w);
+  }
+  if (buf != local) {
+    ggtl_dealloc(g, buf);
+  }
+  return ok;
+#else
+  (void)g;
+  (void)w;
+  (void)ply;
+  (void)plytogo;
+  (void)alpha;
+  (void)beta;
+  return 0;
+#endif
+}
+
+/* Wait for a worker to finish its search. Returns the worker with
+ * the score in C<score> (GGTL_ERR if the worker failed), or NULL if
+ * no worker is searching. The counts of the search are added to
+ * those of C<g>. */
+struct ggtl_worker *net_recv(GGTL *g, int *score)
+{
+#if HAVE_SOCKETS
+  struct ggtl_worker *w = NULL;
+  struct pollfd *fds;
+  unsigned char reply[NET_REPLY];
+  int i;
+  unsigned k;
+
+  if (!net_busy(g)) {
+    return NULL;
+  }
+
+  fds = ggtl_alloc(g, g->nworkers * sizeof *fds);
+  if (fds) {
+    for (i = 0; i < g->nworkers; i++) {
+      fds[i].fd = g->workers[i].m ? g->workers[i].fd : -1;
+      fds[i].events = POLLIN;
+      fds[i].revents = 0;
+    }
+    while (poll(fds, g->nworkers, -1) < 0 && errno == EINTR)
+      ;
+    for (i = 0; i < g->nworkers && !w; i++) {
+      if (fds[i].revents) {
+        w = g->workers + i;
+      }
+    }
+    ggtl_dealloc(g, fds);
+  }
+  if (!w) {
+    /* can't wait for them all; block on the first */
+    for (w = g->workers; !w->m; w++)
+      ;
+  }
+
+  if (!net_read(w->fd, reply, sizeof reply)) {
+    net_close(w);
+    *score = GGTL_ERR;
+    return w;
+  }
+  *score = get32(reply);
+  for (k = 0; k < NET_KEYS; k++) {
+    g->opts[net_keys[k]] += get32(reply + 4 + 4 * k);
+  }
+  return w;
+#else
+  (void)g;
+  (void)score;
+  return NULL;
+#endif
+}
+
+/* Tell the workers they are done, and close their sockets. */
+void net_free(GGTL *g)
+{
+#if HAVE_SOCKETS
+  unsigned char quit[5];
+  int i;
+
+  put32(quit, 1);
+  quit[4] = NET_QUIT;
+  for (i = 0; i < g->nworkers; i++) {
+    if (g->workers[i].fd >= 0) {
+      (void)net_write(g->workers[i].fd, quit, sizeof quit);
+      close(g->workers[i].fd);
+    }
+  }
+#endif
+  ggtl_dealloc(g, g->workers);
+  g->workers = NULL;
+  g->nworkers = 0;
+}
+
+/*
+
+=back
+
+=head1 SEE ALSO
+
+L<ggtl(3)|ggtl>, L<ggtlai(3)|ggtlai>, L<ggtlcb(3)|ggtlcb>
+
+=head1 AUTHOR
+
+Stig Brautaset <stig@brautaset.org>
+
+=head1 COPYRIGHT
+
+Copyright (C) 2005-2006 Stig Brautaset
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+=cut
+
+*/
@@ -0,0 +1,204 @@
+/*
+GGTL - 2-player strategic games AI.
+Copyright (C) 2005-2006 Stig Brautaset. All rights reserved.
+
+This file is part of GGTL.
+
+GGTL is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+GGTL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GGTL; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/*
+
+=begin internal
+
+Move ordering heuristics used by the alpha-beta search. Moves are
+identified by the key returned from the C<move_key()> callback.
+
+Killer moves are the last C<KILLER_SLOTS> moves that caused a
+cutoff at each ply; they are likely to cause a cutoff in sibling
+positions too. The history table counts, for every move key, how
+much cutoffs by that move have been worth anywhere in the tree.
+
+The move list is not sorted, as the C<fitness> member of the
+moves is used to remember the order they were generated in.
+Instead the most promising move is picked from the list each
+time a move is to be searched.
+
+=end internal
+
+=cut
+
+*/
+
+#include <assert.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sl/sl.h>
+
+#include "core.h"
+#include "private.h"
+
+/* Returns the key of move C<m>, or -1 if it has none */
+static int move_key(GGTL *g, GGTL_MOVE *m)
+{
+  int key = g->vtab->move_key(m->data, g);
+  return key >= 0 && key < GGTL_MOVE_KEYS ? key : -1;
+}
+
+/* Returns how early move C<m> should be searched at C<height>
+ * plies below the root; higher values are searched first. */
+static long priority(GGTL *g, GGTL_MOVE *m, int height)
+{
+  int i, key = move_key(g, m);
+
+  if (key < 0) {
+    return 0;
+  }
+
+  if (ggtl_get(g, KILLERS) && height < g->killer_plies) {
+    int *k = g->killers + height * KILLER_SLOTS;
+    for (i = 0; i < KILLER_SLOTS; i++) {
+      if (k[i] == key) {
+        return LONG_MAX - i;
+      }
+    }
+  }
+
+  if (ggtl_get(g, HISTORY) && g->history) {
+    return g->history[key];
+  }
+  return 0;
+}
+
+/* Returns true if any of the heuristics are in use */
+static int ordering(GGTL *g)
+{
+  return g->vtab->move_key && (ggtl_get(g, KILLERS) || ggtl_get(g, HISTORY));
+}
+
+/* Prepare for a new search. Killer moves are forgotten, and
+ * history scores from earlier searches are made to count less than
+ * those of the new one. */
+void order_reset(GGTL *g)
+{
+  int i;
+
+  for (i = 0; i < g->killer_plies * KILLER_SLOTS; i++) {
+    g->killers[i] = -1;
+  }
+
+  if (ggtl_get(g, HISTORY) && !g->history) {
+    g->history = ggtl_alloc(g, GGTL_MOVE_KEYS * sizeof *g->history);
+    if (g->history) {
+      memset(g->history, 0, GGTL_MOVE_KEYS * sizeof *g->history);
+    }
+  }
+  else if (g->history) {
+    for (i = 0; i < GGTL_MOVE_KEYS; i++) {
+      g->history[i] /= 2;
+    }
+  }
+}
+
+void order_free(GGTL *g)
+{
+  ggtl_dealloc(g, g->killers);
+  ggtl_dealloc(g, g->history);
+  g->killers = g->history = NULL;
+  g->killer_plies = 0;
+}
+
+/* Remove the move to search next from C<moves> and return it.
+ * Without any heuristics in use, this is simply the first. */
+GGTL_MOVE *order_pick(GGTL *g, GGTL_MOVE **moves, int height)
+{
+  GGTL_MOVE *m, *prev, *best, *bestprev;
+  long p, bestp;
+
+  if (!*moves || !ordering(g)) {
+    return sl_pop(moves);
+  }
+
+  best = *moves;
+  bestprev = NULL;
+  bestp = priority(g, best, height);
+  for (prev = best, m = best->next; m; prev = m, m = m->next) {
+    p = priority(g, m, height);
+    if (p > bestp) {
+      best = m;
+      bestp = p;
+      bestprev = prev;
+    }
+  }
+
+  if (bestprev) {
+    bestprev->next = best->next;
+  }
+  else {
+    *moves = best->next;
+  }
+  best->next = NULL;
+  return best;
+}
+
+/* Record that move C<m> caused a cutoff at C<height> plies below
+ * the root, with C<plytogo> plies left to search. */
+void order_cutoff(GGTL *g, GGTL_MOVE *m, int height, int plytogo)
+{
+  int i, key;
+
+  if (!ordering(g) || (key = move_key(g, m)) < 0) {
+    return;
+  }
+
+  if (ggtl_get(g, KILLERS)) {
+    int *k;
+
+    if (height >= g->killer_plies) {
+      int plies = height + 8;
+      k = mem_realloc(g, g->killers,
+                      g->killer_plies * KILLER_SLOTS * sizeof *k,
+                      plies * KILLER_SLOTS * sizeof *k);
+      if (!k) {
+        return;
+      }
+      for (i = g->killer_plies * KILLER_SLOTS; i < plies * KILLER_SLOTS; i++) {
+        k[i] = -1;
+      }
+      g->killers = k;
+      g->killer_plies = plies;
+    }
+
+    /* the newest killer goes in the first slot */
+    k = g->killers + height * KILLER_SLOTS;
+    if (k[0] != key) {
+      for (i = KILLER_SLOTS - 1; i > 0; i--) {
+        k[i] = k[i - 1];
+      }
+      k[0] = key;
+    }
+  }
+
+  if (ggtl_get(g, HISTORY) && g->history) {
+    if (g->history[key] > INT_MAX / 2) {
+      for (i = 0; i < GGTL_MOVE_KEYS; i++) {
+        g->history[i] /= 2;
+      }
+    }
+    g->history[key] += plytogo * plytogo;
+  }
+}
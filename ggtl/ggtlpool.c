@@ -0,0 +1,465 @@
+/*
+GGTL - 2-player strategic games AI.
+Copyright (C) 2005-2006 Stig Brautaset. All rights reserved.
+
+This file is part of GGTL.
+
+GGTL is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+GGTL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GGTL; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+#if 0 /* C comments don't nest */
+
+=head1 NAME
+
+ggtlpool - share a few threads among many GGTL structures
+
+=head1 SYNOPSIS
+
+  #include <ggtl/core.h>
+
+  static void done(GGTL *g, void *state, void *data)
+  {
+    /* the AI has moved; tell the player, or submit the next move */
+  }
+
+  GGTL_POOL *p = ggtl_pool_new(4);
+  ggtl_pool_submit(p, g1, done, player1);
+  ggtl_pool_submit(p, g2, done, player2);
+  ...
+  ggtl_pool_wait(p);
+  printf("mean latency: %f\n", ggtl_pool_get(p, POOL_LATENCY));
+  ggtl_pool_free(p);
+
+=head1 DESCRIPTION
+
+A pool is a fixed number of threads that make AI moves (see
+C<ggtl_ai_move()>) for any number of GGTL structures. This lets
+you play many games at once without a thread for each.
+
+Each move submitted is given a deadline: the time it was
+submitted plus the C<TIME> option of the GGTL structure. Moves
+waiting for a thread are made in order of their deadlines, so a
+game with a short C<TIME> is not held up by those with long ones.
+
+A GGTL structure must not be used by anyone else from the time it
+is submitted until its callback has been called. Separate
+structures share nothing (see L<ggtl(3)|ggtl>), so the callbacks
+need not be thread-safe as long as they only touch the state and
+the GGTL structure they are passed.
+
+If GGTL is built without POSIX threads, moves are made at once by
+the thread submitting them.
+
+=head1 FUNCTIONS
+
+=over
+
+=cut
+
+#endif
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "core.h"
+#include "private.h"
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD_CREATE
+#include <pthread.h>
+#define HAVE_THREADS 1
+#endif
+
+struct ggtl_job {
+  struct ggtl_job *next;
+  GGTL *g;
+  void (*done)(GGTL *, void *, void *);
+  void *data;
+  double submitted;
+  double deadline;
+};
+
+struct ggtl_pool {
+  struct ggtl_job *queue;       /* sorted by deadline */
+  int queued;
+  int running;
+  int quit;
+
+  /* statistics */
+  int jobs;
+  int late;
+  double wait, max_wait;
+  double latency, max_latency;
+
+#if HAVE_THREADS
+  pthread_mutex_t lock;
+  pthread_cond_t work;          /* signalled when a job is queued */
+  pthread_cond_t idle;          /* signalled when the pool is idle */
+  pthread_t *threads;
+  int nthreads;
+#endif
+};
+
+static void pool_lock(GGTL_POOL *p)
+{
+#if HAVE_THREADS
+  pthread_mutex_lock(&p->lock);
+#else
+  (void)p;
+#endif
+}
+
+static void pool_unlock(GGTL_POOL *p)
+{
+#if HAVE_THREADS
+  pthread_mutex_unlock(&p->lock);
+#else
+  (void)p;
+#endif
+}
+
+/* Make the move of C<job> and call its callback. Called without the
+ * lock held; C<p->running> must have been incremented. */
+static void pool_run(GGTL_POOL *p, struct ggtl_job *job)
+{
+  double started, finished, wait, latency;
+  void *state;
+
+  started = ai_clock();
+  state = ggtl_ai_move(job->g);
+  finished = ai_clock();
+
+  wait = started - job->submitted;
+  latency = finished - job->submitted;
+
+  pool_lock(p);
+  p->jobs++;
+  p->wait += wait;
+  p->latency += latency;
+  if (wait > p->max_wait) {
+    p->max_wait = wait;
+  }
+  if (latency > p->max_latency) {
+    p->max_latency = latency;
+  }
+  if (finished > job->deadline) {
+    p->late++;
+  }
+  pool_unlock(p);
+
+  /* the callback may submit the next move */
+  job->done(job->g, state, job->data);
+  free(job);
+
+  pool_lock(p);
+  p->running--;
+#if HAVE_THREADS
+  if (!p->running && !p->queue) {
+    pthread_cond_broadcast(&p->idle);
+  }
+#endif
+  pool_unlock(p);
+}
+
+#if HAVE_THREADS
+static void *pool_main(void *arg)
+{
+  GGTL_POOL *p = arg;
+
+  pool_lock(p);
+  for (;;) {
+    struct ggtl_job *job;
+
+    while (!p->queue && !p->quit) {
+      pthread_cond_wait(&p->work, &p->lock);
+    }
+    if (!p->queue) {
+      break;
+    }
+    job = p->queue;
+    p->queue = job->next;
+    p->queued--;
+    p->running++;
+    pool_unlock(p);
+
+    pool_run(p, job);
+
+    pool_lock(p);
+  }
+  pool_unlock(p);
+  return NULL;
+}
+#endif
+
+/*
+
+=item GGTL_POOL *ggtl_pool_new( int threads )
+
+Returns a new pool of C<threads> threads (at least one), or NULL on
+failure.
+
+=cut
+
+*/
+
+GGTL_POOL *ggtl_pool_new(int threads)
+{
+  GGTL_POOL *p;
+
+  p = calloc(1, sizeof *p);
+  if (!p) {
+    return NULL;
+  }
+
+#if HAVE_THREADS
+  if (threads < 1) {
+    threads = 1;
+  }
+  p->threads = malloc(threads * sizeof *p->threads);
+  if (!p->threads) {
+    free(p);
+    return NULL;
+  }
+  pthread_mutex_init(&p->lock, NULL);
+  pthread_cond_init(&p->work, NULL);
+  pthread_cond_init(&p->idle, NULL);
+
+  for (p->nthreads = 0; p->nthreads < threads; p->nthreads++) {
+    if (pthread_create(p->threads + p->nthreads, NULL, pool_main, p)) {
+      break;
+    }
+  }
+  if (!p->nthreads) {
+    ggtl_pool_free(p);
+    return NULL;
+  }
+#else
+  (void)threads;
+#endif
+
+  return p;
+}
+
+/*
+
+=item int ggtl_pool_submit( GGTL_POOL *p, *g, void (*done)(GGTL *, void *, void *), void *data )
+
+Queue an AI move for C<g>. When the move has been made, C<done> is
+called from one of the pool's threads with C<g>, the new state (as
+returned by C<ggtl_ai_move()>, so NULL if no move could be made) and
+C<data>. Returns 1 on success, or 0 if the move could not be queued.
+
+=cut
+
+*/
+
+int ggtl_pool_submit(GGTL_POOL *p, GGTL *g,
+                     void (*done)(GGTL *, void *, void *), void *data)
+{
+  struct ggtl_job *job, **pos;
+
+  assert(g != NULL);
+  assert(done != NULL);
+
+  job = malloc(sizeof *job);
+  if (!job) {
+    return 0;
+  }
+  job->g = g;
+  job->done = done;
+  job->data = data;
+  job->submitted = ai_clock();
+  job->deadline = job->submitted + ggtl_get_float(g, TIME);
+
+#if HAVE_THREADS
+  pool_lock(p);
+  for (pos = &p->queue; *pos; pos = &(*pos)->next) {
+    if ((*pos)->deadline > job->deadline) {
+      break;
+    }
+  }
+  job->next = *pos;
+  *pos = job;
+  p->queued++;
+  pthread_cond_signal(&p->work);
+  pool_unlock(p);
+#else
+  (void)pos;
+  p->running++;
+  pool_run(p, job);
+#endif
+
+  return 1;
+}
+
+/*
+
+=item void ggtl_pool_wait( GGTL_POOL *p )
+
+Wait until no moves are queued or being made. Moves submitted by
+the callbacks are waited for too.
+
+=cut
+
+*/
+
+void ggtl_pool_wait(GGTL_POOL *p)
+{
+#if HAVE_THREADS
+  pool_lock(p);
+  while (p->queue || p->running) {
+    pthread_cond_wait(&p->idle, &p->lock);
+  }
+  pool_unlock(p);
+#else
+  (void)p;
+#endif
+}
+
+/*
+
+=item double ggtl_pool_get( GGTL_POOL *p, int key )
+
+Returns statistics for the moves made by the pool so far, to help
+you decide how many threads it needs. Times are in seconds.
+C<key> is one of:
+
+=over
+
+=item POOL_JOBS
+
+The number of moves made.
+
+=item POOL_QUEUED
+
+The number of moves waiting for a thread.
+
+=item POOL_WAIT, POOL_MAX_WAIT
+
+The mean and longest time moves waited for a thread.
+
+=item POOL_LATENCY, POOL_MAX_LATENCY
+
+The mean and longest time from submitting a move until it was
+made (not counting the callback).
+
+=item POOL_LATE
+
+The number of moves made after their deadline. If this keeps
+growing, the pool needs more threads.
+
+=back
+
+=cut
+
+*/
+
+double ggtl_pool_get(GGTL_POOL *p, int key)
+{
+  double value = 0;
+
+  assert(key >= 0);
+  assert(key < POOL_KEYS);
+
+  pool_lock(p);
+  switch (key) {
+  case POOL_JOBS:
+    value = p->jobs;
+    break;
+  case POOL_QUEUED:
+    value = p->queued;
+    break;
+  case POOL_WAIT:
+    value = p->jobs ? p->wait / p->jobs : 0;
+    break;
+  case POOL_MAX_WAIT:
+    value = p->max_wait;
+    break;
+  case POOL_LATENCY:
+    value = p->jobs ? p->latency / p->jobs : 0;
+    break;
+  case POOL_MAX_LATENCY:
+    value = p->max_latency;
+    break;
+  case POOL_LATE:
+    value = p->late;
+    break;
+  }
+  pool_unlock(p);
+
+  return value;
+}
+
+/*
+
+=item void ggtl_pool_free( GGTL_POOL *p )
+
+Wait for the queued moves to be made, then stop the threads and
+free the pool. The GGTL structures are not freed.
+
+=cut
+
+*/
+
+void ggtl_pool_free(GGTL_POOL *p)
+{
+  if (!p) {
+    return;
+  }
+
+#if HAVE_THREADS
+  {
+    int i;
+
+    pool_lock(p);
+    p->quit = 1;
+    pthread_cond_broadcast(&p->work);
+    pool_unlock(p);
+    for (i = 0; i < p->nthreads; i++) {
+      pthread_join(p->threads[i], NULL);
+    }
+    free(p->threads);
+    pthread_mutex_destroy(&p->lock);
+    pthread_cond_destroy(&p->work);
+    pthread_cond_destroy(&p->idle);
+  }
+#endif
+  free(p);
+}
+
+/*
+
+=back
+
+=head1 SEE ALSO
+
+L<ggtl(3)|ggtl>, L<ggtlai(3)|ggtlai>
+
+=head1 AUTHOR
+
+Stig Brautaset <stig@brautaset.org>
+
+=head1 COPYRIGHT
+
+Copyright (C) 2005-2006 Stig Brautaset
+
+This program is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+=cut
+
+*/
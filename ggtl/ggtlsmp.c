@@ -0,0 +1,391 @@
+/*
+GGTL - 2-player strategic games AI.
+Copyright (C) 2005-2006 Stig Brautaset. All rights reserved.
+
+This file is part of GGTL.
+
+GGTL is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+GGTL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GGTL; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/*
+
+=begin internal
+
+Helper threads for the parallel AIs. Each helper is a fork (see
+C<ggtl_fork()>) of the instance it helps, with its own copy of
+the root state, its own caches and move ordering tables, but the
+transposition table of the instance it helps. Nothing else is shared, so the callbacks
+need not be thread-safe as long as they only touch the state and
+the C<GGTL> instance they are passed.
+
+For the iterative AIs ("Lazy SMP") the helpers search the same
+position as the main thread, and the main thread picks up their
+results from the shared table. For YBWC and C<ROOT_PARALLEL> the
+helpers wait for the main thread to hand them moves to search;
+the lock and condition variable used for that are kept here.
+
+Helpers are started before the main search and stopped after it.
+Their counters are kept until the next search, for
+C<ggtl_get_thread()>.
+
+The background searches of C<ggtl_ai_move_start()> are also run
+here.
+
+If GGTL is built without POSIX threads, no helpers are started,
+and background searches are made at once by the caller.
+
+=end internal
+
+=cut
+
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+#include "private.h"
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD_CREATE
+#include <pthread.h>
+#define HAVE_THREADS 1
+#endif
+
+struct ggtl_helper {
+  GGTL *g;              /* the helper's own instance */
+  int id;
+  int running;
+  void (*run)(GGTL *, int);
+  int opts[GET_KEYS];   /* its counters after it stopped */
+#if HAVE_THREADS
+  pthread_t thread;
+#endif
+};
+
+#if HAVE_THREADS
+struct ggtl_sync {
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+};
+#endif
+
+struct ggtl_async {
+  GGTL *g;
+  void *(*run)(GGTL *);
+  void (*done)(GGTL *, void *, void *);
+  void *data;
+#if HAVE_THREADS
+  pthread_t thread;
+  pthread_mutex_t lock;
+  int finished;
+#endif
+};
+
+#if HAVE_THREADS
+/* Returns a new instance set up to help C<g> search its current
+ * position, or NULL on error. */
+static GGTL *helper_new(GGTL *g)
+{
+  GGTL *h = ggtl_fork_internal(g);
+
+  if (h) {
+    h->opts[TRACE] = 0; /* only the main thread talks */
+    h->tt = g->tt;
+    h->stop = &g->smp_stop;
+    h->master = g;
+  }
+  return h;
+}
+
+static void *helper_main(void *arg)
+{
+  struct ggtl_helper *hp = arg;
+  hp->run(hp->g, hp->id);
+  return NULL;
+}
+#endif
+
+/* Start THREADS-1 helpers for the search about to be made by C<g>,
+ * each running C<run>. Helpers need the clone_state() callback.
+ * Returns the number of helpers started. */
+int smp_start(GGTL *g, void (*run)(GGTL *, int))
+{
+  int i, n = ggtl_get(g, THREADS) - 1;
+
+  smp_free(g);
+  if (n < 1 || !g->vtab->clone_state) {
+    return 0;
+  }
+
+#if HAVE_THREADS
+  g->sync = ggtl_alloc(g, sizeof *g->sync);
+  if (!g->sync) {
+    return 0;
+  }
+  pthread_mutex_init(&g->sync->lock, NULL);
+  pthread_cond_init(&g->sync->cond, NULL);
+
+  g->helpers = ggtl_alloc(g, n * sizeof *g->helpers);
+  if (!g->helpers) {
+    return 0;
+  }
+  memset(g->helpers, 0, n * sizeof *g->helpers);
+  g->smp_stop = 0;
+
+  for (i = 0; i < n; i++) {
+    struct ggtl_helper *hp = g->helpers + i;
+    hp->id = i + 1;
+    hp->run = run;
+    hp->g = helper_new(g);
+    if (!hp->g) {
+      break;
+    }
+    if (pthread_create(&hp->thread, NULL, helper_main, hp)) {
+      hp->g->tt = NULL;
+      ggtl_free(hp->g);
+      break;
+    }
+    hp->running = 1;
+  }
+  g->nhelpers = i;
+  ai_trace(g, 1, "started %d helper threads", i);
+#else
+  (void)i;
+  (void)run;
+#endif
+
+  return g->nhelpers;
+}
+
+/* Stop the helpers and wait for them to finish. Their counters are
+ * kept, and the instances freed. If C<join> is true, their counters
+ * are also added to those of C<g>. */
+void smp_stop(GGTL *g, int join)
+{
+  int i;
+
+  smp_lock(g);
+  g->smp_stop = 1;
+  smp_wake(g);
+  smp_unlock(g);
+  for (i = 0; i < g->nhelpers; i++) {
+    struct ggtl_helper *hp = g->helpers + i;
+    if (!hp->running) {
+      continue;
+    }
+#if HAVE_THREADS
+    pthread_join(hp->thread, NULL);
+#endif
+    hp->running = 0;
+    memcpy(hp->opts, hp->g->opts, sizeof hp->opts);
+    hp->g->tt = NULL;   /* not the helper's to free */
+    if (join) {
+      ggtl_join(g, hp->g);
+    }
+    else {
+      ggtl_free(hp->g);
+    }
+    hp->g = NULL;
+  }
+}
+
+void smp_free(GGTL *g)
+{
+  smp_stop(g, 0);
+  ggtl_dealloc(g, g->helpers);
+  g->helpers = NULL;
+  g->nhelpers = 0;
+#if HAVE_THREADS
+  if (g->sync) {
+    pthread_mutex_destroy(&g->sync->lock);
+    pthread_cond_destroy(&g->sync->cond);
+    ggtl_dealloc(g, g->sync);
+    g->sync = NULL;
+  }
+#endif
+}
+
+/* The lock shared by C<g> and its helpers, and a condition to wait
+ * on while holding it. Waiters are woken by any change; they must
+ * check what they wait for themselves. These do nothing if no
+ * helpers have been started. */
+void smp_lock(GGTL *g)
+{
+#if HAVE_THREADS
+  if (g->sync) {
+    pthread_mutex_lock(&g->sync->lock);
+  }
+#else
+  (void)g;
+#endif
+}
+
+void smp_unlock(GGTL *g)
+{
+#if HAVE_THREADS
+  if (g->sync) {
+    pthread_mutex_unlock(&g->sync->lock);
+  }
+#else
+  (void)g;
+#endif
+}
+
+void smp_wait(GGTL *g)
+{
+#if HAVE_THREADS
+  if (g->sync) {
+    pthread_cond_wait(&g->sync->cond, &g->sync->lock);
+  }
+#else
+  (void)g;
+#endif
+}
+
+void smp_wake(GGTL *g)
+{
+#if HAVE_THREADS
+  if (g->sync) {
+    pthread_cond_broadcast(&g->sync->cond);
+  }
+#else
+  (void)g;
+#endif
+}
+
+/* Returns the value of C<key> for thread number C<thread> in the
+ * last search; thread 0 is C<g> itself. Returns -1 if there was no
+ * such thread. */
+int smp_get(GGTL *g, int thread, int key)
+{
+  if (thread == 0) {
+    return ggtl_get(g, key);
+  }
+  if (thread < 0 || thread > g->nhelpers) {
+    return -1;
+  }
+  assert(!g->helpers[thread - 1].running);
+  return g->helpers[thread - 1].opts[key];
+}
+
+/* Returns true if searches can be run in the background. */
+int smp_async_threaded(void)
+{
+#if HAVE_THREADS
+  return 1;
+#else
+  return 0;
+#endif
+}
+
+/* Run the search of C<a>, and call its callback. */
+static void async_run(struct ggtl_async *a)
+{
+  void *state = a->run(a->g);
+  if (a->done) {
+    a->done(a->g, state, a->data);
+  }
+}
+
+#if HAVE_THREADS
+static void *async_main(void *arg)
+{
+  struct ggtl_async *a = arg;
+
+  async_run(a);
+  pthread_mutex_lock(&a->lock);
+  a->finished = 1;
+  pthread_mutex_unlock(&a->lock);
+  return NULL;
+}
+#endif
+
+/* Start C<run> for C<g> in the background, calling C<done> with the
+ * state it returns and C<data> when it finishes. Without threads it
+ * is run at once. C<g> must have no background search running.
+ * Returns false if it could not be started. */
+int smp_async(GGTL *g, void *(*run)(GGTL *),
+              void (*done)(GGTL *, void *, void *), void *data)
+{
+  struct ggtl_async *a;
+
+  assert(!g->async);
+  a = ggtl_alloc(g, sizeof *a);
+  if (!a) {
+    return 0;
+  }
+  a->g = g;
+  a->run = run;
+  a->done = done;
+  a->data = data;
+
+#if HAVE_THREADS
+  a->finished = 0;
+  pthread_mutex_init(&a->lock, NULL);
+  g->async = a;
+  if (pthread_create(&a->thread, NULL, async_main, a)) {
+    g->async = NULL;
+    pthread_mutex_destroy(&a->lock);
+    ggtl_dealloc(g, a);
+    return 0;
+  }
+#else
+  async_run(a);
+  ggtl_dealloc(g, a);
+#endif
+  return 1;
+}
+
+/* Wait for the background search of C<g>, if any, to finish. */
+void smp_async_join(GGTL *g)
+{
+  struct ggtl_async *a = g->async;
+
+  if (!a) {
+    return;
+  }
+#if HAVE_THREADS
+  pthread_join(a->thread, NULL);
+  pthread_mutex_destroy(&a->lock);
+#endif
+  ggtl_dealloc(g, a);
+  g->async = NULL;
+}
+
+/* Returns true if C<g> has no background search running. One that
+ * has finished is cleaned up. */
+int smp_async_done(GGTL *g)
+{
+#if HAVE_THREADS
+  struct ggtl_async *a = g->async;
+  int finished;
+
+  if (!a) {
+    return 1;
+  }
+  pthread_mutex_lock(&a->lock);
+  finished = a->finished;
+  pthread_mutex_unlock(&a->lock);
+  if (!finished) {
+    return 0;
+  }
+  smp_async_join(g);
+#else
+  (void)g;
+#endif
+  return 1;
+}
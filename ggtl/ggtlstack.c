@@ -0,0 +1,145 @@
+/*
+GGTL - 2-player strategic games AI.
+Copyright (C) 2005-2006 Stig Brautaset. All rights reserved.
+
+This file is part of GGTL.
+
+GGTL is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+GGTL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GGTL; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+
+/*
+
+=begin internal
+
+Stack of the states made by C<ggtl_move_internal()> when the
+C<state_size> member of the vtable is set (and there is no
+C<unmove()> callback). Each state is copied into the next slot of
+the stack and the move made on the copy there, which saves cloning
+the state and allocating a node for it; undoing the move just
+takes the slot off the stack again.
+
+The stack is made of segments of C<STACK_SLOTS> slots, each holding
+a C<GGTL_STATE> node and the state it points to, so the states
+don't move when the stack grows. Segments are kept when they are
+no longer in use, until C<state_size> changes.
+
+=end internal
+
+=cut
+
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <sl/sl.h>
+
+#include "core.h"
+#include "private.h"
+
+/* Bytes needed for C<size> bytes, rounded up to keep alignment */
+#define ALIGNED(size) \
+  (((size) + sizeof(union ggtl_align) - 1) / sizeof(union ggtl_align) \
+   * sizeof(union ggtl_align))
+
+/* Returns the node in slot C<i> of segment C<s> */
+static GGTL_STATE *slot(struct ggtl_stack *s, int i)
+{
+  return (GGTL_STATE *)((char *)s->slots + i * s->slot);
+}
+
+/* Frees segment C<s> and those after it */
+static void free_from(GGTL *g, struct ggtl_stack *s)
+{
+  struct ggtl_stack *next;
+
+  for (; s; s = next) {
+    next = s->next;
+    ggtl_dealloc(g, s);
+  }
+}
+
+/* Returns a new node on top of the stack, pointing to room for a
+ * state of C<state_size> bytes, or NULL if there is no memory for
+ * another segment. */
+GGTL_STATE *stack_push(GGTL *g)
+{
+  size_t size = ALIGNED(sizeof(GGTL_STATE))
+    + ALIGNED((size_t)g->vtab->state_size);
+  struct ggtl_stack *s = g->stack;
+  GGTL_STATE *n;
+
+  if (!s || s->used == STACK_SLOTS || s->slot != size) {
+    struct ggtl_stack *prev = s;
+
+    s = prev ? prev->next : g->stacks;
+    if (s && s->slot != size) {
+      /* spare segments for states of another size */
+      free_from(g, s);
+      s = NULL;
+    }
+    if (!s) {
+      s = ggtl_alloc(g, sizeof *s + STACK_SLOTS * size);
+      if (!s) {
+        if (prev) {
+          prev->next = NULL;
+        }
+        else {
+          g->stacks = NULL;
+        }
+        return NULL;
+      }
+      s->prev = prev;
+      s->next = NULL;
+      s->slot = size;
+      if (prev) {
+        prev->next = s;
+      }
+      else {
+        g->stacks = s;
+      }
+    }
+    s->used = 0;
+    g->stack = s;
+  }
+
+  n = slot(s, s->used++);
+  n->next = NULL;
+  n->data = (char *)n + ALIGNED(sizeof(GGTL_STATE));
+  return n;
+}
+
+/* Takes C<n> off the stack if it is the node on top of it. Returns
+ * true if it was, and false if C<n> is some other node. */
+int stack_pop(GGTL *g, GGTL_STATE *n)
+{
+  struct ggtl_stack *s = g->stack;
+
+  if (!n || !s || n != slot(s, s->used - 1)) {
+    return 0;
+  }
+  if (!--s->used) {
+    g->stack = s->prev;
+  }
+  return 1;
+}
+
+void stack_free(GGTL *g)
+{
+  assert(!g->stack);
+  free_from(g, g->stacks);
+  g->stacks = NULL;
+}
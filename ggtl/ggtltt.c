@@ -0,0 +1,231 @@
+/*
+GGTL - 2-player strategic games AI.
+Copyright (C) 2005-2006 Stig Brautaset. All rights reserved.
+
+This file is part of GGTL.
+
+GGTL is free software; you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation; either version 2 of the License, or
+(at your option) any later version.
+
+GGTL is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with GGTL; if not, write to the Free Software
+Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
+
+*/
+
+/*
+
+=begin internal
+
+Transposition table used by the alpha-beta search. The table is a
+plain array of C<TT_SIZE> entries owned by the C<GGTL> struct;
+positions are mapped to slots by the value returned from the
+C<hash()> callback.
+
+Helper threads share the table of the instance they help, and
+store to it without locking. Each entry is copied before it is
+looked at, and its key is only recognised if the rest of the copy
+is what was stored with it.
+
+If the C<TT_SHM> option is set, the table is a POSIX shared-memory
+segment mapped by every process using that name, and is shared in
+the same way. Entries record the process that stored them, so
+hits on the work of other processes can be counted.
+
+=end internal
+
+=cut
+
+*/
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+#include "private.h"
+
+#if HAVE_SYS_MMAN_H && HAVE_SHM_OPEN
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define HAVE_SHM 1
+#endif
+
+/* Map a table of C<size> entries in the shared-memory segment named
+ * by C<tt_shm>, creating it if it doesn't exist. Returns 1 on
+ * success, or 0 on failure or if the segment is of another size. */
+static int tt_map(GGTL *g, int size)
+{
+#if HAVE_SHM
+  size_t bytes = (size_t)size * sizeof *g->tt;
+  struct stat st;
+  void *p;
+  int fd;
+
+  fd = shm_open(g->tt_shm, O_RDWR | O_CREAT, 0600);
+  if (fd < 0) {
+    return 0;
+  }
+  /* a new segment is filled with zeros, which are empty entries */
+  if (fstat(fd, &st)
+      || (st.st_size && (size_t)st.st_size != bytes)
+      || (!st.st_size && ftruncate(fd, bytes))) {
+    close(fd);
+    return 0;
+  }
+  p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    return 0;
+  }
+  g->tt = p;
+  g->tt_mapped = bytes;
+  g->tt_owner = getpid();
+  return 1;
+#else
+  (void)g;
+  (void)size;
+  return 0;
+#endif
+}
+
+/* Resize the table to hold C<size> entries. A size of 0 frees
+ * the table. Returns the new size, which is 0 if the allocation
+ * failed. */
+int tt_resize(GGTL *g, int size)
+{
+  tt_free(g);
+  if (size > 0 && g->tt_shm) {
+    g->opts[TT_SHM] = tt_map(g, size);
+  }
+  else if (size > 0) {
+    g->tt = ggtl_alloc(g, size * sizeof *g->tt);
+    if (g->tt) {
+      memset(g->tt, 0, size * sizeof *g->tt);
+    }
+  }
+  return g->tt ? size : 0;
+}
+
+void tt_free(GGTL *g)
+{
+#if HAVE_SHM
+  if (g->tt_mapped) {
+    munmap((void *)g->tt, g->tt_mapped);
+    g->tt_mapped = 0;
+    g->tt = NULL;
+    g->opts[TT_SHM] = 0;
+  }
+#endif
+  ggtl_dealloc(g, g->tt);
+  g->tt = NULL;
+}
+
+/* Set the name of the shared-memory segment for the table, or
+ * unset it if C<name> is NULL. The table is not changed. Returns
+ * 0 if the name could not be copied. */
+int tt_share(GGTL *g, const char *name)
+{
+  char *copy = NULL;
+
+  if (name) {
+    copy = ggtl_alloc(g, strlen(name) + 1);
+    if (!copy) {
+      return 0;
+    }
+    strcpy(copy, name);
+  }
+  ggtl_dealloc(g, g->tt_shm);
+  g->tt_shm = copy;
+  return 1;
+}
+
+/* Mix the members of C<e> other than the check into one value */
+static unsigned long tt_sum(const struct ggtl_tt *e)
+{
+  return (unsigned long)e->score
+    ^ ((unsigned long)e->depth << 8)
+    ^ ((unsigned long)e->move << 16)
+    ^ ((unsigned long)e->bound << 28)
+    ^ ((unsigned long)e->age << 30)
+    ^ (unsigned long)e->owner * 2654435761UL;
+}
+
+/* Look up C<key>. Returns true if the stored entry was searched
+ * deep enough to decide the value of the position within the
+ * (alpha, beta) window; the value is then put in C<score>. The
+ * index of the stored best move (or -1) is put in C<move> whenever
+ * the key matches, so it can be tried first. */
+int tt_probe(GGTL *g, unsigned long key, int depth, int alpha, int beta,
+             int *score, int *move)
+{
+  struct ggtl_tt e;
+
+  assert(g->tt != NULL);
+  e = g->tt[key % ggtl_get(g, TT_SIZE)];
+
+  *move = -1;
+  if (!e.bound || (e.check ^ tt_sum(&e)) != key) {
+    g->opts[TT_MISSES]++;
+    return 0;
+  }
+
+  g->opts[TT_HITS]++;
+  if (e.owner != g->tt_owner) {
+    g->opts[TT_SHARED_HITS]++;
+  }
+  *move = e.move;
+  if (e.depth < depth) {
+    return 0;
+  }
+
+  *score = e.score;
+  switch (e.bound) {
+    case TT_EXACT:
+      return 1;
+    case TT_LOWER:
+      return e.score >= beta;
+    case TT_UPPER:
+      return e.score <= alpha;
+  }
+  return 0;
+}
+
+/* Store a search result. Entries from earlier searches are always
+ * replaced; within the same search the deeper result is kept. */
+void tt_store(GGTL *g, unsigned long key, int depth, int bound,
+              int score, int move)
+{
+  struct ggtl_tt e;
+  struct ggtl_tt *slot;
+
+  assert(g->tt != NULL);
+  slot = g->tt + key % ggtl_get(g, TT_SIZE);
+  e = *slot;
+
+  if (e.bound && e.age == g->tt_age && e.depth > depth) {
+    return;
+  }
+
+  if (move < 0 && e.bound && (e.check ^ tt_sum(&e)) == key) {
+    move = e.move;      /* don't forget a known good move */
+  }
+
+  e.depth = depth;
+  e.bound = bound;
+  e.score = score;
+  e.move = move;
+  e.age = g->tt_age;
+  e.owner = g->tt_owner;
+  e.check = key ^ tt_sum(&e);
+  *slot = e;
+}
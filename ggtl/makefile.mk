@@ -1,8 +1,11 @@
 lib_LTLIBRARIES         = libggtl.la libnim.la libreversi.la
-ggtl_LDFLAGS            = -no-undefined -version-info 2:1:0
+ggtl_LDFLAGS            = -no-undefined -version-info 3:0:0
 
 
-libggtl_la_SOURCES      = ggtl/ggtl.c ggtl/ggtlai.c ggtl/private.h
+libggtl_la_SOURCES      = ggtl/ggtl.c ggtl/ggtlai.c ggtl/ggtltt.c \
+                          ggtl/ggtlorder.c ggtl/ggtlsmp.c ggtl/ggtlpool.c \
+                          ggtl/ggtlnet.c ggtl/ggtlarena.c ggtl/ggtlstack.c \
+                          ggtl/private.h
 libggtl_la_LDFLAGS      = $(ggtl_LDFLAGS)
 
 libnim_la_SOURCES       = ggtl/nim.c
@@ -19,6 +22,8 @@ nobase_include_HEADERS  = ggtl/core.h \
 
 man3_MANS              += ggtl/ggtl.3 \
                           ggtl/ggtlai.3 \
+                          ggtl/ggtlpool.3 \
+                          ggtl/ggtlnet.3 \
                           ggtl/ggtlcb.man \
                           ggtl/nim.3 \
                           ggtl/reversi.3
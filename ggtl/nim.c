@@ -72,6 +72,8 @@ GGTL *nim_init(GGTL *g, void *s)
   ggtl_vtab(g)->unmove = &nim_unmove;
   ggtl_vtab(g)->get_moves = &nim_get_moves;
   ggtl_vtab(g)->eval = &nim_eval;
+  ggtl_vtab(g)->hash = &nim_hash;
+  ggtl_vtab(g)->release_move = &nim_move_release;
   
   return ggtl_init(g, s);
 }
@@ -145,6 +147,27 @@ int nim_eval( void *state, GGTL *g )
 }
     
 
+/*
+
+=item unsigned long nim_hash( void *state, GGTL *g )
+
+Returns a hash key for the given state. Two states are only
+equal if the value and the player to move are, so the key is
+unique.
+
+=cut
+
+*/
+
+unsigned long nim_hash( void *state, GGTL *g )
+{
+  struct nim_state *s = state;
+  (void)g;
+
+  return (unsigned long)s->value * 2 + (s->player == 1);
+}
+
+
 /*
 
 =item void *nim_move( void *state, void *move, GGTL *g )
@@ -216,7 +239,7 @@ GGTL_MOVE *nim_get_moves( void *state, GGTL *g )
     assert(n != NULL);
 
     if (!m) {
-      n->data = m = malloc( sizeof *m );
+      n->data = m = ggtl_alloc( g, sizeof *m );
     }
     assert(m != NULL);
 
@@ -227,6 +250,22 @@ GGTL_MOVE *nim_get_moves( void *state, GGTL *g )
   return moves;
 }
 
+/*
+
+=item void nim_move_release( void *move, GGTL *g )
+
+Frees a move made by C<nim_get_moves()>, with the allocator of
+C<g>. This is the release_move() callback.
+
+=cut
+
+*/
+
+void nim_move_release( void *move, GGTL *g )
+{
+  ggtl_dealloc(g, move);
+}
+
 
 /*
 
@@ -44,7 +44,9 @@ struct nim_move *nim_move_new( int val );
 void *nim_move(void *s, void *m, GGTL *g);
 void *nim_unmove(void *s, void *m, GGTL *g);
 GGTL_MOVE *nim_get_moves(void *s, GGTL *g);
+void nim_move_release(void *m, GGTL *g);
 int nim_eval(void *state, GGTL *g);
+unsigned long nim_hash(void *state, GGTL *g);
 
 #ifdef __cplusplus
 }
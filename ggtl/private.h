@@ -25,6 +25,85 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 
 #define GGTL_ERR (GGTL_FITNESS_MAX+1)
 
+/* transposition table bound types */
+enum { TT_EXACT = 1, TT_LOWER, TT_UPPER };
+
+/* ProbCut parameters can be given for depths below this */
+#define PROBCUT_DEPTHS 32
+
+/* ProbCut parameters for one depth: the score of a search to this
+ * depth is estimated as a * (score of a search to shallow) + b,
+ * with error sigma */
+struct ggtl_probcut {
+  int shallow;  /* 0 if no parameters */
+  float a, b, sigma;
+};
+
+/* killer moves remembered per ply */
+#define KILLER_SLOTS 2
+
+/* depth recorded for final states; valid at any remaining depth */
+#define TT_DEPTH_END INT_MAX
+
+/* Entries can be shared by helper threads without locking, so the
+ * key is stored XORed with the rest of the entry; an entry torn by
+ * concurrent stores fails to match its key and is ignored. */
+struct ggtl_tt {
+  unsigned long check;  /* key ^ tt_sum() of the other members */
+  int depth;    /* remaining depth the score was searched to */
+  int bound;    /* TT_EXACT, TT_LOWER or TT_UPPER (0 if unused) */
+  int score;
+  int move;     /* index of best move in get_moves() order, or -1 */
+  int age;      /* search the entry was stored in */
+  int owner;    /* process that stored the entry */
+};
+
+/* A remote worker, and the root move it is searching (NULL if it
+ * is idle) with that move's index as given by root_index() */
+struct ggtl_worker {
+  int fd;       /* -1 once the worker has failed */
+  GGTL_MOVE *m;
+  int pos;
+};
+
+/* Moves generated by get_moves_array() for one level of ab(), and
+ * the nodes linking them into a list */
+struct ggtl_plybuf {
+  void *moves;          /* room for size moves of move_size bytes */
+  GGTL_MOVE *nodes;
+  int size;
+};
+
+/* A slab of the node arena (see ARENA); room for size nodes, and
+ * a count of them on the spare list, made when the arena is trimmed */
+union ggtl_node {
+  GGTL_STATE s;
+  GGTL_MOVE m;
+};
+struct ggtl_slab {
+  struct ggtl_slab *next;
+  int size;
+  int spare;
+  union ggtl_node nodes[1];
+};
+
+/* A segment of the state stack (see state_size in ggtlcb(3)); room
+ * for STACK_SLOTS slots of slot bytes, each a GGTL_STATE node
+ * followed by its state, of which used are taken */
+#define STACK_SLOTS 32
+union ggtl_align {
+  double d;
+  long l;
+  void *p;
+};
+struct ggtl_stack {
+  struct ggtl_stack *prev;
+  struct ggtl_stack *next;
+  size_t slot;
+  int used;
+  union ggtl_align slots[1];
+};
+
 struct ggtl {
   GGTL_VTAB *vtab;
 
@@ -41,6 +120,109 @@ struct ggtl {
 
   /* optimisation for end of search */
   int saw_end;
+
+  /* search all but the first move with a null window */
+  int pvs;
+
+  /* return the best score found even if it is outside the window */
+  int fail_soft;
+
+  /* ProbCut parameters indexed by depth, and threshold */
+  struct ggtl_probcut probcut[PROBCUT_DEPTHS];
+  float probcut_t;
+  int in_probcut;
+
+  /* time at which a search is aborted (0 for none) */
+  double deadline;
+  int aborted;
+
+  /* helper threads; a helper aborts its search when the flag
+   * pointed to by stop is set by the instance it is helping */
+  struct ggtl_helper *helpers;
+  int nhelpers;
+  struct ggtl_sync *sync;
+  volatile int smp_stop;
+  volatile int *stop;
+  GGTL *master;         /* the instance a helper helps */
+
+  /* YBWC and ROOT_PARALLEL: split the search among helpers, and
+   * the split point they are working on */
+  int ybwc;
+  int root_parallel;
+  struct ggtl_split *split;
+
+  /* ggtl_ai_move_start()'s background search, and the flag set
+   * by ggtl_stop() */
+  struct ggtl_async *async;
+  volatile int halt;
+
+  /* pondering: the fork searching the position after the predicted
+   * reply, that reply, our copy of it (if it could be copied), and
+   * the hash of the position. In the fork, whether the
+   * opponent is yet to move, and the flag set when it has */
+  GGTL *ponder;
+  void *ponder_move;
+  void *ponder_copy;
+  unsigned long ponder_key;
+  int pondering;
+  volatile int ponder_hit;
+
+  /* time the clock started for the current search */
+  double started;
+
+  /* incremental search (ggtl_search_begin()), and the number of
+   * states visited at which its current step ends */
+  struct ggtl_inc *inc;
+  int node_limit;
+
+  /* remote workers (ggtl_add_worker()) */
+  struct ggtl_worker *workers;
+  int nworkers;
+
+  /* move buffers for get_moves_array(), and the number in use */
+  struct ggtl_plybuf *plybufs;
+  int nplybufs;
+  int ply_depth;
+
+  /* ab()'s stack of frames, and the number in use */
+  struct ggtl_frame *frames;
+  int nframes;
+  int frame_depth;
+
+  /* node arena: its slabs (newest first), the number of nodes
+   * handed out from the newest, the empty nodes handed back, and
+   * whether a search is using it */
+  struct ggtl_slab *slabs;
+  int slab_used;
+  void *spare;
+  int arena_on;
+
+  /* state stack: its first segment, and the one holding the top
+   * state (NULL if the stack is empty) */
+  struct ggtl_stack *stacks;
+  struct ggtl_stack *stack;
+
+  /* transposition table; if it is in a shared-memory segment, the
+   * name and mapped size of that, and the owner of our entries */
+  struct ggtl_tt *tt;
+  int tt_age;
+  char *tt_shm;
+  size_t tt_mapped;
+  int tt_owner;
+
+  /* allocator (ggtl_set_allocator()) */
+  void *(*alloc)(size_t, void *);
+  void (*dealloc)(void *, void *);
+  void *alloc_ctx;
+
+  /* random number generator state, and where trace goes */
+  unsigned long rng;
+  FILE *trace;
+
+  /* move ordering heuristics */
+  int *killers;         /* KILLER_SLOTS move keys per ply */
+  int killer_plies;
+  int *history;         /* cutoff scores indexed by move key */
 };
 
 /* The various AIs */
@@ -48,10 +230,78 @@ GGTL_MOVE *ai_none(GGTL *g, GGTL_MOVE *);
 GGTL_MOVE *ai_random(GGTL *g, GGTL_MOVE *);
 GGTL_MOVE *ai_fixed(GGTL *g, GGTL_MOVE *);
 GGTL_MOVE *ai_iterative(GGTL *g, GGTL_MOVE *);
+GGTL_MOVE *ai_pvs(GGTL *g, GGTL_MOVE *);
+GGTL_MOVE *ai_mtdf(GGTL *g, GGTL_MOVE *);
+GGTL_MOVE *ai_ybwc(GGTL *g, GGTL_MOVE *);
+void ai_helper(GGTL *g, int id);
+void ai_worker(GGTL *g, int id);
+GGTL_STATE *ai_predict(GGTL *g);
+int ai_begin(GGTL *g, GGTL_MOVE *moves);
+int ai_step(GGTL *g, int nodes);
+GGTL_MOVE *ai_result(GGTL *g);
+GGTL_MOVE *ai_end(GGTL *g, int best);
+int ai_serve(GGTL *g, int ply, int plytogo, int alpha, int beta);
+void ply_free(GGTL *g);
 
 
 /* Helper functions */
+void *mem_realloc(GGTL *g, void *block, size_t old, size_t size);
+void state_release(GGTL *g, void *state);
+void move_release(GGTL *g, void *move);
 void ai_trace(GGTL *g, int level, char *fmt, ...);
+int ai_rand(GGTL *g, int n);
+double ai_clock(void);
 int fitness_cmp(void *anode, void *bnode);
 
+/* Transposition table */
+int tt_resize(GGTL *g, int size);
+void tt_free(GGTL *g);
+int tt_share(GGTL *g, const char *name);
+int tt_probe(GGTL *g, unsigned long key, int depth, int alpha, int beta,
+             int *score, int *move);
+void tt_store(GGTL *g, unsigned long key, int depth, int bound,
+              int score, int move);
+
+/* Helper threads */
+int smp_start(GGTL *g, void (*run)(GGTL *, int));
+void smp_stop(GGTL *g, int join);
+void smp_free(GGTL *g);
+int smp_get(GGTL *g, int thread, int key);
+void smp_lock(GGTL *g);
+void smp_unlock(GGTL *g);
+void smp_wait(GGTL *g);
+void smp_wake(GGTL *g);
+int smp_async(GGTL *g, void *(*run)(GGTL *),
+              void (*done)(GGTL *, void *, void *), void *data);
+int smp_async_done(GGTL *g);
+int smp_async_threaded(void);
+void smp_async_join(GGTL *g);
+
+/* Remote workers */
+struct ggtl_worker *net_idle(GGTL *g);
+int net_busy(GGTL *g);
+int net_send(GGTL *g, struct ggtl_worker *w, int ply, int plytogo,
+             int alpha, int beta);
+struct ggtl_worker *net_recv(GGTL *g, int *score);
+void net_free(GGTL *g);
+
+/* Node arena */
+void arena_start(GGTL *g);
+void *arena_node(GGTL *g);
+int arena_owns(GGTL *g, void *node);
+GGTL_MOVE *arena_stop(GGTL *g, GGTL_MOVE *move);
+int arena_spare(GGTL *g, void *node);
+void arena_free(GGTL *g);
+
+/* State stack */
+GGTL_STATE *stack_push(GGTL *g);
+int stack_pop(GGTL *g, GGTL_STATE *n);
+void stack_free(GGTL *g);
+
+/* Move ordering */
+void order_reset(GGTL *g);
+void order_free(GGTL *g);
+GGTL_MOVE *order_pick(GGTL *g, GGTL_MOVE **moves, int height);
+void order_cutoff(GGTL *g, GGTL_MOVE *m, int height, int plytogo);
+
 #endif /* !_ggtl_private_h */
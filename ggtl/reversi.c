@@ -39,9 +39,18 @@ GGTL-Reversi- GGTL extension for playing Reversi (aka Othello)
   /* callback functions used by ggtl core */
   void *reversi_state_clone(void *state, GGTL *g);
   int reversi_eval(void *state, GGTL *g);
+  unsigned long reversi_hash(void *state, GGTL *g);
+  int reversi_move_key(void *move, GGTL *g);
   void reversi_state_free(void *state);
+  void reversi_state_release(void *state, GGTL *g);
   GGTL_MOVE *reversi_get_moves(void *state, GGTL *g);
+  GGTL_MOVE *reversi_get_noisy_moves(void *state, GGTL *g);
+  void *reversi_null_move(void *state, GGTL *g);
   void *reversi_move(void *s, void *mv, GGTL *g);
+  int reversi_get_moves_array(void *state, void *moves, int max, GGTL *g);
+  int reversi_serialize(void *state, unsigned char *buf, int size,
+                        GGTL *g);
+  void *reversi_deserialize(const unsigned char *buf, int len, GGTL *g);
 
 See L<reversi-demo(3)|reversi-demo> for a complete example of a
 self-playing Reversi game using this extension.
@@ -98,6 +107,7 @@ Three data structures are used by this GGTL extension. They are:
 #include "reversi.h"
 
 static int move_internal(RState *s, int x, int y);
+static RState *state_new(int size, GGTL *g);
 static int valid_move(RState *s, int me, int x, int y);
 
 /*
@@ -117,6 +127,11 @@ player 1 is set to start.
 */
 
 RState *reversi_state_new(int size)
+{
+  return state_new(size, NULL);
+}
+
+static RState *state_new(int size, GGTL *g)
 {
   RState *state;
 
@@ -124,11 +139,11 @@ RState *reversi_state_new(int size)
     return NULL;
   }
 
-  state = malloc(sizeof *state);
+  state = ggtl_alloc(g, sizeof *state);
   if (state) {
-    state->board = malloc(size * (sizeof(int*)));
+    state->board = ggtl_alloc(g, size * (sizeof(int*)));
     if (state->board) {
-      state->board[0] = malloc(size * size * (sizeof(int)));
+      state->board[0] = ggtl_alloc(g, size * size * (sizeof(int)));
       if (state->board[0]) {
         int i, j;
         for (i = 1; i < size; i++) {
@@ -152,12 +167,12 @@ RState *reversi_state_new(int size)
     state->board[size/2][size/2] = 2;
   }
   else if (state && state->board) {
-    free(state->board);
-    free(state);
+    ggtl_dealloc(g, state->board);
+    ggtl_dealloc(g, state);
     state = NULL;
   }
   else {
-    free(state);
+    ggtl_dealloc(g, state);
     state = NULL;
   }
 
@@ -169,7 +184,9 @@ RState *reversi_state_new(int size)
 =item void *reversi_state_clone( void *s, GGTL *g )
 
 Clone the state C<s> (using a cached state from C<g> if
-available). Return the cloned state, or NULL on error. 
+available, or else the allocator of C<g>; see
+C<ggtl_set_allocator()>). Return the cloned state, or NULL on
+error. 
 
 It is assumed that cached states are the same size as the one
 being cloned.
@@ -184,7 +201,7 @@ void *reversi_state_clone( void *state, GGTL *g )
 
   clone = ggtl_uncache_state_raw(g);
   if (!clone) {
-    clone = reversi_state_new(s->size);
+    clone = state_new(s->size, g);
   }
 
   if (clone) {
@@ -256,8 +273,9 @@ RMove *reversi_move_new(int x, int y)
 =item GGTL_MOVE *reversi_move_new_wrapped( int x, int y, *g )
 
 Returns a new move, wrapped in a C<ggtl_mc> container, or NULL
-on failure. If g is non-NULL it will be asked for a cached move;
-otherwise, a new move will be allocated.
+on failure. The move is packed into the container (see
+C<ggtl_wrap_packed()> in L<ggtl(3)|ggtl>), which is taken from the
+caches of C<g> if they have one.
 
 =cut
 
@@ -268,12 +286,8 @@ GGTL_MOVE *reversi_move_new_wrapped(int x, int y, GGTL *g)
   GGTL_MOVE *n;
   RMove *m;
 
-  n = ggtl_uncache_move(g);
-  if (!n) {
-    n = ggtl_wrap_move(g, malloc(sizeof *m));
-    assert(n != NULL);
-    assert(n->data != NULL);
-  }
+  n = ggtl_wrap_packed(g);
+  assert(n != NULL);
   m = n->data;
   m->x = x;
   m->y = y;
@@ -299,7 +313,14 @@ GGTL *reversi_init(GGTL *g, void *s)
   ggtl_vtab(g)->get_moves = &reversi_get_moves;
   ggtl_vtab(g)->eval = &reversi_eval;
   ggtl_vtab(g)->free_state = &reversi_state_free;
+  ggtl_vtab(g)->release_state = &reversi_state_release;
   ggtl_vtab(g)->clone_state = &reversi_state_clone;
+  ggtl_vtab(g)->hash = &reversi_hash;
+  ggtl_vtab(g)->move_key = &reversi_move_key;
+  ggtl_vtab(g)->serialize = &reversi_serialize;
+  ggtl_vtab(g)->deserialize = &reversi_deserialize;
+  ggtl_vtab(g)->get_moves_array = &reversi_get_moves_array;
+  ggtl_vtab(g)->move_size = sizeof(RMove);
   
   return ggtl_init(g, s);
 }
@@ -355,31 +376,25 @@ Evaluate a reversi state and return its fitness.
 int reversi_eval( void *state, GGTL *g )
 {
   RState *s = state;
-  GGTL_MOVE *moves;
   int mine, diff, me, you;
   struct reversi_counts counts;
 
   me = s->player;
   you = 3 - me;
 
-  moves = ggtl_get_moves(g);
-  if (!moves) {
+  /* count the moves without generating them */
+  mine = reversi_get_moves_array(s, NULL, 0, g);
+  if (!mine) {
     counts = reversi_state_count(s);
     mine = counts.c[me] - counts.c[you];
     return mine > 0 ? GGTL_FITNESS_MAX : 
            mine < 0 ? GGTL_FITNESS_MIN : 0;
   }
 
-  mine = sl_count(moves);
-  ggtl_cache_moves(g, moves);
-
   s->player = 3 - s->player;
-  moves = ggtl_get_moves(g);
+  diff = mine - reversi_get_moves_array(s, NULL, 0, g);
   s->player = 3 - s->player;
 
-  diff = mine - sl_count(moves);
-  ggtl_cache_moves(g, moves);
-
   counts = reversi_state_count(s);
   mine = counts.c[me] - counts.c[you];
 
@@ -388,6 +403,141 @@ int reversi_eval( void *state, GGTL *g )
 
 /*
 
+=item unsigned long reversi_hash( void *state, GGTL *g )
+
+Returns a hash key for the given state, for use by GGTL's
+transposition table. Both the board and the player to move are
+taken into account.
+
+=cut
+
+*/
+
+unsigned long reversi_hash( void *state, GGTL *g )
+{
+  RState *s = state;
+  unsigned long h = 2166136261UL;   /* FNV-1a */
+  int i, j;
+
+  (void)g;
+  for (i = 0; i < s->size; i++) {
+    for (j = 0; j < s->size; j++) {
+      h = (h ^ s->board[i][j]) * 16777619UL;
+    }
+  }
+  return (h ^ s->player) * 16777619UL;
+}
+
+/*
+
+=item int reversi_move_key( void *move, GGTL *g )
+
+Returns a key for the given move, for use by GGTL's move ordering
+heuristics. Moves to the same square get the same key; the pass
+move gets key 0.
+
+=cut
+
+*/
+
+int reversi_move_key( void *move, GGTL *g )
+{
+  RMove *m = move;
+  RState *s = ggtl_peek_state(g);
+  return m->x < 0 ? 0 : 1 + m->x * s->size + m->y;
+}
+
+/*
+
+=item void *reversi_null_move( void *state, GGTL *g )
+
+Passes the turn to the other player, whether or not the current
+player has any moves. This callback can be used for both
+C<null_move()> and C<null_unmove()>. They are not set by
+C<reversi_init()>, as there are Reversi positions (mostly near the
+end of the game) where having to move is a disadvantage, which
+makes null-move pruning unsafe.
+
+=cut
+
+*/
+
+void *reversi_null_move( void *state, GGTL *g )
+{
+  RState *s = state;
+  (void)g;
+  s->player = 3 - s->player;
+  return s;
+}
+
+/*
+
+=item int reversi_serialize( void *state, unsigned char *buf, int size, GGTL *g )
+
+=item void *reversi_deserialize( const unsigned char *buf, int len, GGTL *g )
+
+Convert a state to and from the compact form used to send it to
+other processes; see L<ggtlnet(3)|ggtlnet>. The board size and the
+player to move take a byte each, and the squares two bits each, so
+an 8x8 board takes 18 bytes.
+
+=cut
+
+*/
+
+int reversi_serialize( void *state, unsigned char *buf, int size, GGTL *g )
+{
+  RState *s = state;
+  int i, n = s->size * s->size, len = 2 + (n + 3) / 4;
+
+  (void)g;
+  if (len <= size) {
+    memset(buf, 0, len);
+    buf[0] = s->size;
+    buf[1] = s->player;
+    for (i = 0; i < n; i++) {
+      buf[2 + i / 4] |= s->board[i / s->size][i % s->size] << 2 * (i % 4);
+    }
+  }
+  return len;
+}
+
+void *reversi_deserialize( const unsigned char *buf, int len, GGTL *g )
+{
+  RState *s;
+  int i, n;
+
+  if (len < 2 || len != 2 + (buf[0] * buf[0] + 3) / 4
+      || (buf[1] != 1 && buf[1] != 2)) {
+    return NULL;
+  }
+  s = ggtl_uncache_state_raw(g);
+  if (s && s->size != buf[0]) {
+    reversi_state_release(s, g);
+    s = NULL;
+  }
+  if (!s) {
+    s = state_new(buf[0], g);
+    if (!s) {
+      return NULL;
+    }
+  }
+
+  s->player = buf[1];
+  n = s->size * s->size;
+  for (i = 0; i < n; i++) {
+    int c = buf[2 + i / 4] >> 2 * (i % 4) & 3;
+    if (c > 2) {
+      reversi_state_release(s, g);
+      return NULL;
+    }
+    s->board[i / s->size][i % s->size] = c;
+  }
+  return s;
+}
+
+/*
+
 =item void *reversi_move( void *state, void *move, GGTL *g )
 
 Returns the state resulting from applying C<move> to C<state>, or
@@ -592,6 +742,88 @@ again:
   return moves;
 }
 
+/*
+
+=item int reversi_get_moves_array( void *state, void *moves, int max, GGTL *g )
+
+Like C<reversi_get_moves()>, but puts the moves (up to C<max> of
+them) in the array of C<RMove>s at C<moves>, and returns how many
+there are. For the C<get_moves_array()> callback.
+
+=cut
+
+*/
+
+int reversi_get_moves_array( void *state, void *moves, int max, GGTL *g )
+{
+  RState *s = state;
+  RMove *m = moves;
+  int me, i, j, n = 0;
+
+  (void)g;
+  me = s->player;
+again:
+  /* in the order reversi_get_moves() pushes them onto its list */
+  for (i = s->size - 1; i >= 0; i--) {
+    for (j = s->size - 1; j >= 0; j--) {
+      if (valid_move(s, me, i, j)) {
+        if (me != s->player) {
+          /* the opponent can move; we pass */
+          if (max > 0) {
+            m[0].x = m[0].y = -1;
+          }
+          return 1;
+        }
+        if (n < max) {
+          m[n].x = i;
+          m[n].y = j;
+        }
+        n++;
+      }
+    }
+  }
+
+  if (!n && me == s->player) {
+    me = 3 - me;
+    goto again;
+  }
+  return n;
+}
+
+/*
+
+=item GGTL_MOVE *reversi_get_noisy_moves( void *state, GGTL *g )
+
+Returns a list of the moves to corner squares available at the
+given position, or NULL if there are none. Taking a corner often
+changes the balance of the game a lot. This callback is not set
+by C<reversi_init()>; set it with
+C<ggtl_vtab(g)-E<gt>get_noisy_moves = &reversi_get_noisy_moves>
+to turn on quiescence search.
+
+=cut
+
+*/
+
+GGTL_MOVE *reversi_get_noisy_moves( void *state, GGTL *g )
+{
+  RState *s = state;
+  GGTL_MOVE *moves = NULL;
+  int i, j, last = s->size - 1;
+
+  for (i = 0; i <= last; i += last) {
+    for (j = 0; j <= last; j += last) {
+      if (valid_move(s, s->player, i, j)) {
+        GGTL_MOVE *n = reversi_move_new_wrapped(i, j, g); 
+        assert(n != NULL);
+        moves = sl_push(moves, n);
+      }
+    }
+  }
+
+  return moves;
+}
+
 static int valid_move(RState *s, int me, int x, int y)
 {
   int tx, ty;
@@ -687,6 +919,27 @@ void reversi_state_free(void *state)
   free(s);
 }
 
+/*
+
+=item void reversi_state_release( void *state, GGTL *g )
+
+Like C<reversi_state_free()>, but frees the state with the
+allocator of C<g> (see C<ggtl_set_allocator()> in L<ggtl(3)|ggtl>),
+which C<reversi_state_clone()> allocates states with. This is the
+release_state() callback.
+
+=cut
+
+*/
+
+void reversi_state_release(void *state, GGTL *g)
+{
+  RState *s = state;
+  ggtl_dealloc(g, s->board[0]);
+  ggtl_dealloc(g, s->board);
+  ggtl_dealloc(g, s);
+}
+
 
 /*
 
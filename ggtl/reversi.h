@@ -47,12 +47,20 @@ typedef struct reversi_counts {
 GGTL *reversi_init(GGTL *g, void *s);
 void *reversi_move(void *s, void *m, GGTL *g);
 GGTL_MOVE *reversi_get_moves(void *s, GGTL *g);
+int reversi_get_moves_array(void *s, void *moves, int max, GGTL *g);
 int reversi_eval(void *state, GGTL *g);
+unsigned long reversi_hash(void *state, GGTL *g);
+int reversi_move_key(void *move, GGTL *g);
+GGTL_MOVE *reversi_get_noisy_moves(void *s, GGTL *g);
+void *reversi_null_move(void *s, GGTL *g);
+int reversi_serialize(void *s, unsigned char *buf, int size, GGTL *g);
+void *reversi_deserialize(const unsigned char *buf, int len, GGTL *g);
 RState *reversi_state_new(int size);
 void *reversi_state_clone(void *s, GGTL *g);
 RMove *reversi_move_new(int x, int y);
 GGTL_MOVE *reversi_move_new_wrapped(int x, int y, GGTL *g);
 void reversi_state_free(void *state);
+void reversi_state_release(void *state, GGTL *g);
 void reversi_state_draw(RState *s);
 RStateCount reversi_state_count(RState *s);
 
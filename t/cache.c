@@ -8,7 +8,7 @@ int main(void)
 {
   GGTL *g;
 
-  plan_tests(16);
+  plan_tests(21);
   
   g = ggtl_new();
   assert(g != NULL);
@@ -42,6 +42,26 @@ int main(void)
     ok1( &s == ggtl_uncache_state_raw(g) );
   }
 
+  /* packed moves */
+  {
+    int *m = malloc(sizeof *m);
+    GGTL_MOVE *pc;
+
+    ok1( (pc = ggtl_wrap_packed(g)) && pc->data == pc->packed.c );
+    pc->packed.i = 42;
+    ggtl_cache_moves(g, pc);
+    ok1( pc == ggtl_wrap_packed(g) && 42 == *(long *)pc->data );
+    ggtl_cache_move(g, m);
+    ggtl_cache_moves(g, pc);
+    ok( m == ggtl_uncache_move_raw(g), "packed move passed over" );
+
+    /* the move in a cached container is freed when it is reused */
+    ggtl_cache_move(g, m);
+    ok1( (pc = ggtl_wrap_packed(g)) && pc->data == pc->packed.c );
+    ggtl_cache_moves(g, pc);
+    ok1( !ggtl_uncache_move_raw(g) );
+  }
+
   ok1( !ggtl_uncache_state_raw(g) );
   ok1( !ggtl_uncache_move_raw(g) );
   ok1( !ggtl_uncache_state(g) );
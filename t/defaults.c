@@ -8,12 +8,12 @@ int main(void)
 {
   GGTL *g;
 
-  plan_tests(11);
+  plan_tests(31);
   
   g = ggtl_new();
   ok( g, "setup ok" );
 
-  ok1( 6 == SET_KEYS );
+  ok1( 26 == SET_KEYS );
   ok1( ITERATIVE == ggtl_get(g, TYPE) );
   ok1( 3 == ggtl_get(g, PLY) );
   ok1( abs(200 - ggtl_get(g, MSEC)) <= 1 );
@@ -25,8 +25,28 @@ int main(void)
   
   ok1( 0 == ggtl_get(g, TRACE) );
   ok1( (STATES | MOVES) == ggtl_get(g, CACHE) );
+  ok1( 0 == ggtl_get(g, TT_SIZE) );
+  ok1( 0 == ggtl_get(g, ASPIRATION) );
+  ok1( 4 == ggtl_get(g, ASP_GROWTH) );
+  ok1( 1000 == ggtl_get(g, POLL) );
+  ok1( 0 == ggtl_get(g, HARD_DEADLINE) );
+  ok1( 0 == ggtl_get(g, KILLERS) );
+  ok1( 0 == ggtl_get(g, HISTORY) );
+  ok1( 8 == ggtl_get(g, QS_DEPTH) );
+  ok1( 0 == ggtl_get(g, QS_NODES) );
+  ok1( 0 == ggtl_get(g, NULL_MOVE) );
+  ok1( 0 == ggtl_get(g, LMR) );
+  ok1( 2 == ggtl_get(g, LMR_DEPTH) );
+  ok1( 0 == ggtl_get(g, FUTILITY) );
+  ok1( 1 == ggtl_get(g, FUTILITY_DEPTH) );
+  ok1( 0 == ggtl_get_float(g, PROBCUT) );
+  ok1( 1 == ggtl_get(g, THREADS) );
+  ok1( 0 == ggtl_get(g, ROOT_PARALLEL) );
+  ok1( 1 == ggtl_get(g, SEED) );
+  ok1( 0 == ggtl_get(g, TT_SHM) );
+  ok1( 0 == ggtl_get(g, ARENA) );
 
-  ok1( 2 == GET_KEYS - SET_KEYS);
+  ok1( 16 == GET_KEYS - SET_KEYS);
 
   ggtl_free(g);
   return exit_status();
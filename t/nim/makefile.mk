@@ -1,5 +1,6 @@
 ctests                 += t/nim/ai.t \
-                          t/nim/basic.t
+                          t/nim/basic.t \
+                          t/nim/stack.t
 
 ptests                 += $(srcdir)/t/nim/trace.t
 phelpers               += t/nim/trace 
@@ -11,6 +12,9 @@ t_nim_ai_t_LDFLAGS      = -lnim -ltap
 t_nim_basic_t_SOURCES   = t/nim/basic.c
 t_nim_basic_t_LDFLAGS   = -lnim -ltap
 
+t_nim_stack_t_SOURCES   = t/nim/stack.c
+t_nim_stack_t_LDFLAGS   = -lnim -ltap
+
 # helpers
 t_nim_trace_SOURCES     = t/nim/trace.c
 t_nim_trace_LDFLAGS     = -lnim 
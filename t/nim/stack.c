@@ -0,0 +1,74 @@
+#include <tap.h>
+#include <stdlib.h>
+#include <ggtl/nim.h>
+
+#define PLAYED 40
+
+/* Returns a GGTL structure playing Nim from C<val>, keeping its
+ * states on the state stack if C<stack> is true */
+static GGTL *nim(int val, int stack)
+{
+  GGTL *g = nim_init(ggtl_new(), nim_state_new(1, val));
+
+  if (stack) {
+    ggtl_vtab(g)->unmove = NULL;
+    ggtl_vtab(g)->state_size = sizeof(struct nim_state);
+  }
+  ggtl_set(g, TYPE, FIXED);
+  return g;
+}
+
+int main(void)
+{
+  struct nim_state *s, *first, *states[PLAYED];
+  GGTL *g, *h;
+  int i, moved = 1, undone = 1;
+
+  plan_tests(9);
+
+  g = nim(100, 1);
+  first = ggtl_peek_state(g);
+
+  /* more moves than fit in a segment of the stack */
+  for (i = 0; i < PLAYED && moved; i++) {
+    s = ggtl_move(g, nim_move_new(1));
+    moved = s && s != first && s->value == 99 - i
+      && (!i || s != states[i - 1]);
+    states[i] = s;
+  }
+  ok( moved, "made %d moves on the stack", i );
+  ok1( 100 == first->value && 1 == first->player );
+  ok1( 60 == ((struct nim_state *)ggtl_peek_state(g))->value );
+
+  for (i = PLAYED - 1; i > 0 && undone; i--) {
+    s = ggtl_undo(g);
+    undone = s == states[i - 1] && s->value == 100 - i;
+  }
+  ok( undone, "states kept their places when undone" );
+  ok1( first == ggtl_undo(g) );
+  ok1( !ggtl_undo(g) );
+
+  /* a new size for the states while some are on the stack */
+  ggtl_move(g, nim_move_new(2));
+  ggtl_vtab(g)->state_size = sizeof(struct nim_state) + 24;
+  s = ggtl_move(g, nim_move_new(3));
+  ok1( s && 95 == s->value );
+  ok1( (s = ggtl_undo(g)) && 98 == s->value );
+
+  /* searches are the same as with unmove() */
+  ggtl_free(g);
+  g = nim(30, 1);
+  h = nim(30, 0);
+  ggtl_set(g, PLY, 8);
+  ggtl_set(h, PLY, 8);
+  for (i = 0, undone = 1; undone && ggtl_ai_move(h); i++) {
+    s = ggtl_ai_move(g);
+    undone = s && s->value == ((struct nim_state *)ggtl_peek_state(h))->value
+      && ggtl_get(g, VISITED) == ggtl_get(h, VISITED);
+  }
+  ok( undone && i > 5, "same %d searches as with unmove()", i );
+
+  ggtl_free(h);
+  ggtl_free(g);
+  return exit_status();
+}
@@ -0,0 +1,85 @@
+#include <tap.h>
+#include <stdlib.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+/* a tracking allocator */
+struct tracker {
+  int allocs;   /* calls to alloc */
+  int live;     /* blocks not yet freed */
+};
+
+static void *track_alloc(size_t size, void *ctx)
+{
+  struct tracker *t = ctx;
+  void *p = malloc(size);
+
+  if (p) {
+    t->allocs++;
+    t->live++;
+  }
+  return p;
+}
+
+static void track_dealloc(void *p, void *ctx)
+{
+  struct tracker *t = ctx;
+
+  t->live--;
+  free(p);
+}
+
+int main(void)
+{
+  struct tracker t = { 0, 0 };
+  GGTL *g;
+  RState *s;
+  RMove *m;
+  int before, moves = 0, counted = 1;
+
+  plan_tests(7);
+
+  /* the default allocator is malloc() */
+  m = ggtl_alloc(NULL, sizeof *m);
+  ok( m != NULL, "allocated without a GGTL structure" );
+  free(m);
+  ggtl_dealloc(NULL, NULL);
+
+  /* the allocator is set before anything is allocated, and so is
+   * the starting state */
+  g = ggtl_new();
+  ggtl_set_allocator(g, &track_alloc, &track_dealloc, &t);
+  s = reversi_state_new(6);
+  reversi_init(g, reversi_state_clone(s, g));
+  reversi_state_free(s);
+  ok( t.allocs == 4, "state and its node allocated with it" );
+
+  ggtl_set(g, PLY, 3);
+  before = t.allocs;
+  ggtl_set(g, TT_SIZE, 1024);
+  ggtl_set(g, KILLERS, 1);
+  ggtl_set(g, HISTORY, 1);
+  ok( t.allocs == before + 1, "table allocated with it" );
+
+  do {
+    before = t.allocs;
+    if (!ggtl_ai_move(g)) {
+      break;
+    }
+    if (t.allocs - before != ggtl_get(g, MALLOCS)) {
+      counted = 0;
+    }
+    moves++;
+  } while (moves < 6);
+  ok( moves == 6, "made %d moves", moves );
+  ok( counted, "MALLOCS counts the allocations" );
+  ok( t.allocs > 100, "%d blocks allocated", t.allocs );
+
+  /* moves from malloc() are still freed with free() */
+  ggtl_move(g, reversi_move_new(-1, -1));
+  ggtl_undo(g);
+  ggtl_free(g);
+  ok( t.live == 0, "all blocks freed (%d left)", t.live );
+
+  return exit_status();
+}
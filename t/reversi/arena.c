@@ -0,0 +1,152 @@
+#include <tap.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+/* blocks allocated and not yet freed by a GGTL structure */
+static void *count_alloc(size_t size, void *live)
+{
+  void *p = malloc(size);
+  if (p) {
+    ++*(int *)live;
+  }
+  return p;
+}
+
+static void count_free(void *p, void *live)
+{
+  --*(int *)live;
+  free(p);
+}
+
+static int live_a, live_b;
+
+/* new instances for play(), counting the blocks they hold */
+static void game(GGTL **a, GGTL **b)
+{
+  live_a = live_b = 0;
+  *a = ggtl_new();
+  ggtl_set_allocator(*a, count_alloc, count_free, &live_a);
+  *a = reversi_init(*a, reversi_state_new(6));
+  *b = ggtl_new();
+  ggtl_set_allocator(*b, count_alloc, count_free, &live_b);
+  *b = reversi_init(*b, reversi_state_new(6));
+}
+
+/* make a move with the current AI, and put its coordinates in
+ * C<x> and C<y>, the score in C<score> and the states visited in
+ * C<visited>. The move is undone. */
+static int search(GGTL *g, int *x, int *y, int *score, int *visited)
+{
+  RMove *m;
+
+  if (!ggtl_ai_move(g)) {
+    return 0;
+  }
+  m = ggtl_peek_move(g);
+  *x = m->x;
+  *y = m->y;
+  *score = ggtl_get(g, SCORE);
+  *visited = ggtl_get(g, VISITED);
+  ggtl_undo(g);
+  return 1;
+}
+
+/* Plays a game with C<a> (using the arena) and C<b> (not using
+ * it) in step, searching each position with both. Returns the number
+ * of positions searched, or -1 if the searches differed. The sum of
+ * the allocations made by the searches with and without the arena
+ * are put in C<with> and C<without>, and the most blocks C<a> held
+ * after a search beyond those C<b> held in C<held>. */
+static int play(GGTL *a, GGTL *b, int *with, int *without, int *held)
+{
+  int moves = 0, same = 1;
+
+  ggtl_set(a, ARENA, 64);
+  ggtl_set(b, ARENA, 0);
+  *with = *without = 0;
+  *held = live_a - live_b;
+  do {
+    int x, y, sc, v, x2, y2, sc2, v2;
+    RMove *m;
+
+    ggtl_set(a, TYPE, FIXED);
+    ggtl_set(b, TYPE, FIXED);
+    if (!search(a, &x, &y, &sc, &v)) {
+      break;
+    }
+    *with += ggtl_get(a, MALLOCS);
+    if (!search(b, &x2, &y2, &sc2, &v2)) {
+      same = 0;
+      break;
+    }
+    *without += ggtl_get(b, MALLOCS);
+    if (live_a - live_b > *held) {
+      *held = live_a - live_b;
+    }
+
+    if (x != x2 || y != y2 || sc != sc2 || v != v2) {
+      diag("arena %d,%d (%d, %d states); none %d,%d (%d, %d states)",
+           x, y, sc, v, x2, y2, sc2, v2);
+      same = 0;
+    }
+
+    ggtl_set(a, TYPE, RANDOM);
+    if (!ggtl_ai_move(a)) {
+      break;
+    }
+    m = ggtl_peek_move(a);
+    if (!ggtl_move(b, reversi_move_new(m->x, m->y))) {
+      same = 0;
+      break;
+    }
+    moves++;
+  } while (same);
+
+  return same ? moves : -1;
+}
+
+int main(void)
+{
+  GGTL *a, *b;
+  int moves, with, without, held;
+
+  plan_tests(8);
+
+  /* without the cache every node is new, so the arena saves an
+   * allocation for every node; only the moves and states are
+   * allocated one at a time */
+  game(&a, &b);
+  ggtl_set(a, PLY, 3);
+  ggtl_set(b, PLY, 3);
+  ggtl_set(a, CACHE, 0);
+  ggtl_set(b, CACHE, 0);
+  moves = play(a, b, &with, &without, &held);
+  ok( moves > 10, "searched %d positions without the cache", moves );
+  ok( without > 1000, "%d allocations without the arena", without );
+  ok( with + without / 10 < without, "%d allocations with it", with );
+  ok( held == 1, "only the first slab kept after a search" );
+  ggtl_free(a);
+  ggtl_free(b);
+
+  /* with it, the nodes of the arena are reused from search to search
+   * through the cache, like the nodes allocated one at a time, but
+   * the first ones come from a few slabs */
+  game(&a, &b);
+  ggtl_set(a, PLY, 4);
+  ggtl_set(b, PLY, 4);
+  ggtl_set(a, TT_SIZE, 4096);
+  ggtl_set(b, TT_SIZE, 4096);
+  ggtl_set(a, KILLERS, 1);
+  ggtl_set(b, KILLERS, 1);
+  moves = play(a, b, &with, &without, &held);
+  ok( moves > 10, "searched %d positions with the cache", moves );
+  ok( without > 10, "%d allocations without the arena", without );
+  ok( with < without, "%d allocations with it", with );
+  ok( held < 10, "%d more blocks held with it", held );
+  ggtl_free(a);
+  ggtl_free(b);
+
+  return exit_status();
+}
@@ -0,0 +1,71 @@
+#include <tap.h>
+#include <stdio.h>
+#include <time.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD_CREATE
+#define HAVE_THREADS 1
+#endif
+
+struct result {
+  int called;
+  void *state;
+};
+
+static void done(GGTL *g, void *state, void *data)
+{
+  struct result *r = data;
+  (void)g;
+  r->called++;
+  r->state = state;
+}
+
+int main(void)
+{
+  GGTL *g;
+  struct result r = { 0, NULL };
+  time_t start;
+
+  plan_tests(12);
+
+  /* a search started in the background is finished by polling */
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_set_float(g, TIME, 0.05);
+  ok1( ggtl_ai_move_start(g, done, &r) );
+  while (!ggtl_ai_move_poll(g))
+    ;
+  ok( r.called == 1 && r.state, "callback called with new state" );
+  ok1( r.state == ggtl_peek_state(g) );
+  ok1( ggtl_peek_move(g) );
+
+#if HAVE_THREADS
+  /* a long search is cut short by ggtl_stop() */
+  r.called = 0;
+  ggtl_set_float(g, TIME, 60.0);
+  start = time(NULL);
+  ok1( ggtl_ai_move_start(g, done, &r) );
+  ok( !ggtl_ai_move_start(g, done, &r), "only one search at a time" );
+  ggtl_stop(g);
+  ok( time(NULL) - start < 10, "stopped early" );
+  ok( r.called == 1 && r.state, "a move was made" );
+  ok1( ggtl_ai_move_poll(g) );
+
+  /* so is one of fixed depth */
+  r.called = 0;
+  ggtl_set(g, TYPE, YBWC);
+  ggtl_set(g, THREADS, 2);
+  ggtl_set(g, PLY, 30);
+  start = time(NULL);
+  ok1( ggtl_ai_move_start(g, done, &r) );
+  ggtl_stop(g);
+  ok( time(NULL) - start < 10, "stopped early" );
+  ok( r.called == 1 && r.state, "a move was made" );
+#else
+  (void)start;
+  skip(8, "searches are not made in the background without threads");
+#endif
+
+  ggtl_free(g);
+  return exit_status();
+}
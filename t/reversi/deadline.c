@@ -0,0 +1,35 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+int main(void)
+{
+  GGTL *g;
+  int i, size = 8;
+
+  plan_tests(23);
+
+  g = reversi_init(ggtl_new(), reversi_state_new(size));
+  ok( g, "setup okay" );
+
+  ggtl_set(g, TYPE, ITERATIVE);
+  ggtl_set_float(g, TIME, 0.02);
+  ggtl_set(g, HARD_DEADLINE, 1);
+  ggtl_set(g, POLL, 100);
+  ok1( 100 == ggtl_get(g, POLL) );
+
+  /* the searches are stopped well before they would have ended */
+  ggtl_set(g, PLY, 1);
+  for (i = 0; i < 10; i++) {
+    float over;
+
+    ok( ggtl_ai_move(g), "found a move before the deadline" );
+    over = ggtl_get_float(g, OVERSHOOT);
+    ok( over < 0.05, "overshoot (%f) is small", over );
+  }
+  ok1( 1 == ggtl_get(g, PLY) );
+
+  ggtl_free(g);
+  return exit_status();
+}
@@ -0,0 +1,100 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+/* make a move with the current AI, and put its coordinates in
+ * C<x> and C<y>. The move is undone. */
+static int search(GGTL *g, int *x, int *y)
+{
+  RMove *m;
+
+  if (!ggtl_ai_move(g)) {
+    return 0;
+  }
+  m = ggtl_peek_move(g);
+  *x = m->x;
+  *y = m->y;
+  ggtl_undo(g);
+  return 1;
+}
+
+int main(void)
+{
+  GGTL *g, *f;
+  int visited, same = 1, same2 = 1, moves = 0;
+
+  plan_tests(14);
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_set(g, TYPE, RANDOM);
+  ggtl_ai_move(g);
+  ggtl_set(g, TYPE, FIXED);
+  ggtl_set(g, TT_SIZE, 1024);
+
+  f = ggtl_fork(g);
+  ok( f, "forked" );
+  ok1( f != g && ggtl_peek_state(f) != ggtl_peek_state(g) );
+  ok1( reversi_hash(ggtl_peek_state(f), f) 
+       == reversi_hash(ggtl_peek_state(g), g) );
+  ok1( FIXED == ggtl_get(f, TYPE) );
+  ok1( 1024 == ggtl_get(f, TT_SIZE) );
+  ok( !ggtl_undo(f), "can't undo past the fork" );
+
+  ok1( ggtl_ai_move(f) );
+  ok1( reversi_hash(ggtl_peek_state(f), f) 
+       != reversi_hash(ggtl_peek_state(g), g) );
+  visited = ggtl_get(f, VISITED);
+  ok1( ggtl_ai_move(g) );
+  visited += ggtl_get(g, VISITED);
+  ggtl_join(g, f);
+  ok1( visited == ggtl_get(g, VISITED) );
+
+  ggtl_vtab(g)->clone_state = NULL;
+  ok( !ggtl_fork(g), "can't fork without clone_state()" );
+  ggtl_free(g);
+
+  /* shared out at the root, the same moves are picked */
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_set(g, PLY, 3);
+  ggtl_set(g, THREADS, 3);
+  ggtl_set_float(g, TIME, 0.01);
+  do {
+    int x, y, x2 = -2, y2 = -2, ply;
+
+    ggtl_set(g, TYPE, FIXED);
+    ggtl_set(g, ROOT_PARALLEL, 0);
+    if (!search(g, &x, &y)) {
+      break;
+    }
+    ggtl_set(g, ROOT_PARALLEL, 1);
+    search(g, &x2, &y2);
+    if (x != x2 || y != y2) {
+      diag("FIXED %d,%d; ROOT_PARALLEL %d,%d", x, y, x2, y2);
+      same = 0;
+    }
+
+    ggtl_set(g, TYPE, ITERATIVE);
+    search(g, &x, &y);
+    ply = ggtl_get(g, PLY_REACHED);
+    ggtl_set(g, TYPE, FIXED);
+    ggtl_set(g, ROOT_PARALLEL, 0);
+    ggtl_set(g, PLY, ply);
+    search(g, &x2, &y2);
+    ggtl_set(g, PLY, 3);
+    if (x != x2 || y != y2) {
+      diag("ITERATIVE %d,%d; FIXED %d,%d at ply %d", x, y, x2, y2, ply);
+      same2 = 0;
+    }
+
+    ggtl_set(g, TYPE, RANDOM);
+    moves++;
+  } while (ggtl_ai_move(g));
+
+  ok( moves > 10, "searched %d positions", moves );
+  ok( same, "FIXED picks the same moves" );
+  ok( same2, "ITERATIVE picks the same moves" );
+  ggtl_free(g);
+
+  return exit_status();
+}
@@ -0,0 +1,151 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+#define STEP 25
+
+int main(void)
+{
+  GGTL *g, *f;
+  RMove *m, *fm;
+  int ret, steps = 0, bounded = 1, visited = 0, score;
+
+  plan_tests(21);
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_set(g, TYPE, FIXED);
+  ggtl_set(g, PLY, 5);
+  ggtl_ai_move(g);
+  ggtl_ai_move(g);
+
+  f = ggtl_fork(g);
+  ok1( ggtl_ai_move(f) );
+  fm = ggtl_peek_move(f);
+  score = ggtl_get(f, SCORE);
+
+  ok1( ggtl_search_begin(g) );
+  ok1( ggtl_search_result(g) );
+  while (!(ret = ggtl_search_step(g, STEP))) {
+    int v = ggtl_get(g, VISITED) + ggtl_get(g, QS_VISITED);
+    if (v - visited > STEP) {
+      bounded = 0;
+    }
+    visited = v;
+    steps++;
+  }
+  ok1( ret == 1 );
+  ok( steps > 1, "took %d steps", steps );
+  ok( bounded, "each step visited at most %d states", STEP );
+  ok1( 5 == ggtl_get(g, PLY_REACHED) );
+  ok1( score == ggtl_get(g, SCORE) );
+
+  m = ggtl_search_result(g);
+  ok( m->x == fm->x && m->y == fm->y, "same move as FIXED" );
+  ok1( ggtl_search_end(g) );
+  m = ggtl_peek_move(g);
+  ok( m->x == fm->x && m->y == fm->y, "move made" );
+
+  /* a search is ended by moves */
+  ggtl_search_begin(g);
+  ggtl_search_step(g, STEP);
+  ggtl_undo(g);
+
+  ggtl_free(f);
+  ggtl_free(g);
+
+  /* without a transposition table, and with steps far smaller than
+   * the search of a root move, a step carries on where the last
+   * one left off */
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_vtab(g)->hash = NULL;
+  ggtl_set(g, TYPE, FIXED);
+  ggtl_set(g, PLY, 6);
+  ggtl_ai_move(g);
+  ggtl_ai_move(g);
+
+  f = ggtl_fork(g);
+  ok1( ggtl_ai_move(f) );
+  fm = ggtl_peek_move(f);
+  score = ggtl_get(f, SCORE);
+
+  ok1( ggtl_search_begin(g) );
+  steps = 0;
+  while (!(ret = ggtl_search_step(g, STEP)) && steps < 100000) {
+    steps++;
+  }
+  ok( ret == 1, "done in %d steps", steps );
+  ok1( score == ggtl_get(g, SCORE) );
+  m = ggtl_search_result(g);
+  ok( m->x == fm->x && m->y == fm->y, "same move as FIXED" );
+
+  ggtl_free(f);
+  ggtl_free(g);
+
+  /* ggtl_stop() does not cut short the quiescence searches of an
+   * incremental search, whether it was called before or during it */
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_vtab(g)->get_noisy_moves = reversi_get_noisy_moves;
+  ggtl_set(g, QS_DEPTH, 4);
+  ggtl_set(g, TYPE, RANDOM);
+  for (steps = 0; steps < 14; steps++) {
+    ggtl_ai_move(g);
+  }
+  ggtl_set(g, PLY, 3);
+  f = ggtl_fork(g);
+  ggtl_search_begin(f);
+  while (!ggtl_search_step(f, STEP))
+    ;
+  fm = ggtl_search_result(f);
+
+  ggtl_stop(g);
+  ok1( ggtl_search_begin(g) );
+  steps = 0;
+  while (!(ret = ggtl_search_step(g, STEP)) && steps < 100000) {
+    ggtl_stop(g);
+    steps++;
+  }
+  m = ggtl_search_result(g);
+  ok( ret == 1 && ggtl_get(f, SCORE) == ggtl_get(g, SCORE)
+      && ggtl_get(f, QS_VISITED) == ggtl_get(g, QS_VISITED)
+      && m->x == fm->x && m->y == fm->y, "same search as without it" );
+
+  ggtl_free(f);
+  ggtl_free(g);
+
+  /* the selective search options and aspiration windows are used,
+   * and small steps make the same search as one big one */
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_vtab(g)->null_move = &reversi_null_move;
+  ggtl_vtab(g)->null_unmove = &reversi_null_move;
+  ggtl_set(g, NULL_MOVE, 1);
+  ggtl_set(g, LMR, 2);
+  ggtl_set(g, ASPIRATION, 2);
+  ggtl_set(g, TYPE, FIXED);
+  ggtl_set(g, PLY, 5);
+  ggtl_ai_move(g);
+  ggtl_ai_move(g);
+
+  f = ggtl_fork(g);
+  ggtl_search_begin(f);
+  ret = ggtl_search_step(f, 1000000);
+  fm = ggtl_search_result(f);
+  ok( ret == 1 && ggtl_get(f, NULL_CUTOFFS) > 0, "%d null-move cutoffs",
+      ggtl_get(f, NULL_CUTOFFS) );
+  ok( ggtl_get(f, LMR_REDUCED) > 0, "%d moves reduced",
+      ggtl_get(f, LMR_REDUCED) );
+
+  ggtl_search_begin(g);
+  steps = 0;
+  while (!(ret = ggtl_search_step(g, STEP)) && steps < 100000) {
+    steps++;
+  }
+  m = ggtl_search_result(g);
+  ok( ret == 1 && ggtl_get(f, SCORE) == ggtl_get(g, SCORE)
+      && ggtl_get(f, VISITED) == ggtl_get(g, VISITED)
+      && m->x == fm->x && m->y == fm->y, "same search in %d steps", steps );
+
+  ggtl_free(f);
+  ggtl_free(g);
+  return exit_status();
+}
@@ -1,7 +1,29 @@
 ctests                 += t/reversi/get_moves.t \
                           t/reversi/eval.t \
                           t/reversi/iterative.t \
-                          t/reversi/time.t
+                          t/reversi/time.t \
+                          t/reversi/tt.t \
+                          t/reversi/pvs.t \
+                          t/reversi/aspiration.t \
+                          t/reversi/deadline.t \
+                          t/reversi/ordering.t \
+                          t/reversi/quiescence.t \
+                          t/reversi/selective.t \
+                          t/reversi/mtdf.t \
+                          t/reversi/probcut.t \
+                          t/reversi/smp.t \
+                          t/reversi/ybwc.t \
+                          t/reversi/fork.t \
+                          t/reversi/reentrant.t \
+                          t/reversi/pool.t \
+                          t/reversi/async.t \
+                          t/reversi/ponder.t \
+                          t/reversi/incremental.t \
+                          t/reversi/remote.t \
+                          t/reversi/shm.t \
+                          t/reversi/moves_array.t \
+                          t/reversi/arena.t \
+                          t/reversi/allocator.t
 
 ptests                 += $(srcdir)/t/reversi/move.t \
                           $(srcdir)/t/reversi/trace.t
@@ -21,6 +43,72 @@ t_reversi_iterative_t_LDFLAGS     = -lreversi -ltap
 t_reversi_time_t_SOURCES          = t/reversi/time.c
 t_reversi_time_t_LDFLAGS          = -lreversi -ltap
 
+t_reversi_tt_t_SOURCES            = t/reversi/tt.c
+t_reversi_tt_t_LDFLAGS            = -lreversi -ltap
+
+t_reversi_pvs_t_SOURCES           = t/reversi/pvs.c
+t_reversi_pvs_t_LDFLAGS           = -lreversi -ltap
+
+t_reversi_aspiration_t_SOURCES    = t/reversi/aspiration.c
+t_reversi_aspiration_t_LDFLAGS    = -lreversi -ltap
+
+t_reversi_deadline_t_SOURCES      = t/reversi/deadline.c
+t_reversi_deadline_t_LDFLAGS      = -lreversi -ltap
+
+t_reversi_ordering_t_SOURCES      = t/reversi/ordering.c
+t_reversi_ordering_t_LDFLAGS      = -lreversi -ltap
+
+t_reversi_quiescence_t_SOURCES    = t/reversi/quiescence.c
+t_reversi_quiescence_t_LDFLAGS    = -lreversi -ltap
+
+t_reversi_selective_t_SOURCES     = t/reversi/selective.c
+t_reversi_selective_t_LDFLAGS     = -lreversi -ltap
+
+t_reversi_mtdf_t_SOURCES          = t/reversi/mtdf.c
+t_reversi_mtdf_t_LDFLAGS          = -lreversi -ltap
+
+t_reversi_probcut_t_SOURCES       = t/reversi/probcut.c
+t_reversi_probcut_t_LDFLAGS       = -lreversi -ltap
+
+t_reversi_smp_t_SOURCES           = t/reversi/smp.c
+t_reversi_smp_t_LDFLAGS           = -lreversi -ltap
+
+t_reversi_ybwc_t_SOURCES          = t/reversi/ybwc.c
+t_reversi_ybwc_t_LDFLAGS          = -lreversi -ltap
+
+t_reversi_fork_t_SOURCES          = t/reversi/fork.c
+t_reversi_fork_t_LDFLAGS          = -lreversi -ltap
+
+t_reversi_reentrant_t_SOURCES     = t/reversi/reentrant.c
+t_reversi_reentrant_t_LDFLAGS     = -lreversi -ltap
+
+t_reversi_pool_t_SOURCES          = t/reversi/pool.c
+t_reversi_pool_t_LDFLAGS          = -lreversi -ltap
+
+t_reversi_async_t_SOURCES         = t/reversi/async.c
+t_reversi_async_t_LDFLAGS         = -lreversi -ltap
+
+t_reversi_ponder_t_SOURCES        = t/reversi/ponder.c
+t_reversi_ponder_t_LDFLAGS        = -lreversi -ltap
+
+t_reversi_incremental_t_SOURCES   = t/reversi/incremental.c
+t_reversi_incremental_t_LDFLAGS   = -lreversi -ltap
+
+t_reversi_remote_t_SOURCES        = t/reversi/remote.c
+t_reversi_remote_t_LDFLAGS        = -lreversi -ltap
+
+t_reversi_shm_t_SOURCES           = t/reversi/shm.c
+t_reversi_shm_t_LDFLAGS           = -lreversi -ltap
+
+t_reversi_moves_array_t_SOURCES   = t/reversi/moves_array.c
+t_reversi_moves_array_t_LDFLAGS   = -lreversi -ltap
+
+t_reversi_arena_t_SOURCES         = t/reversi/arena.c
+t_reversi_arena_t_LDFLAGS         = -lreversi -ltap
+
+t_reversi_allocator_t_SOURCES     = t/reversi/allocator.c
+t_reversi_allocator_t_LDFLAGS     = -lreversi -ltap
+
 # helpers
 t_reversi_move_SOURCES            = t/reversi/move.c
 t_reversi_move_LDFLAGS            = -lreversi 
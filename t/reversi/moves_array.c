@@ -0,0 +1,99 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+/* Returns true if reversi_get_moves_array() gives the same moves in
+ * the same order as reversi_get_moves(). */
+static int same_moves(GGTL *g)
+{
+  RMove buf[64];
+  GGTL_MOVE *moves, *m;
+  int i, n, same;
+
+  moves = reversi_get_moves(ggtl_peek_state(g), g);
+  n = reversi_get_moves_array(ggtl_peek_state(g), buf, 64, g);
+  same = n == sl_count(moves);
+  for (i = 0, m = moves; same && m; i++, m = m->next) {
+    RMove *rm = m->data;
+    same = rm->x == buf[i].x && rm->y == buf[i].y;
+  }
+  ggtl_cache_moves(g, moves);
+
+  /* too small a buffer is not written past */
+  buf[0].x = -2;
+  if (n && reversi_get_moves_array(ggtl_peek_state(g), buf, 0, g) != n) {
+    same = 0;
+  }
+  return same && buf[0].x == -2;
+}
+
+/* make a move with the current AI, and put its coordinates in
+ * C<x> and C<y>, the score in C<score> and the states visited in
+ * C<visited>. The move is undone. */
+static int search(GGTL *g, int *x, int *y, int *score, int *visited)
+{
+  RMove *m;
+
+  if (!ggtl_ai_move(g)) {
+    return 0;
+  }
+  m = ggtl_peek_move(g);
+  *x = m->x;
+  *y = m->y;
+  *score = ggtl_get(g, SCORE);
+  *visited = ggtl_get(g, VISITED);
+  ggtl_undo(g);
+  return 1;
+}
+
+int main(void)
+{
+  GGTL *g;
+  int moves = 0, generated = 1, same = 1;
+
+  plan_tests(3);
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_set(g, PLY, 4);
+  ggtl_set(g, TT_SIZE, 4096);
+  ggtl_set(g, KILLERS, 1);
+
+  do {
+    int x, y, sc, v, x2, y2, sc2, v2;
+
+    if (!same_moves(g)) {
+      generated = 0;
+    }
+
+    ggtl_set(g, TYPE, FIXED);
+    ggtl_set(g, TT_SIZE, 4096);
+    if (!search(g, &x, &y, &sc, &v)) {
+      break;
+    }
+
+    ggtl_vtab(g)->get_moves_array = NULL;
+    ggtl_set(g, TT_SIZE, 4096);
+    if (!search(g, &x2, &y2, &sc2, &v2)) {
+      same = 0;
+      break;
+    }
+    ggtl_vtab(g)->get_moves_array = &reversi_get_moves_array;
+
+    if (x != x2 || y != y2 || sc != sc2 || v != v2) {
+      diag("array %d,%d (%d, %d states); list %d,%d (%d, %d states)",
+           x, y, sc, v, x2, y2, sc2, v2);
+      same = 0;
+    }
+
+    ggtl_set(g, TYPE, RANDOM);
+    moves++;
+  } while (ggtl_ai_move(g));
+
+  ok( moves > 10, "searched %d positions", moves );
+  ok( generated, "same moves as reversi_get_moves()" );
+  ok( same, "same moves, scores and states visited as with lists" );
+
+  ggtl_free(g);
+  return exit_status();
+}
@@ -0,0 +1,52 @@
+#include <tap.h>
+#include <stdio.h>
+#include <time.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+int main(void)
+{
+  GGTL *g;
+  int size = 6;
+  int visited = 0, visited2 = 0;
+  clock_t t, t2 = 0, t3 = 0;
+
+  plan_no_plan();
+
+  g = reversi_init(ggtl_new(), reversi_state_new(size));
+  ok( g, "setup okay" );
+  ggtl_set_float(g, TIME, 0.05);
+
+  do {
+    int ply, score;
+
+    ggtl_set(g, TYPE, MTDF);
+    ok1( MTDF == ggtl_get(g, TYPE) );
+
+    t = clock();
+    ok( ggtl_ai_move(g), "performed MTD(f) search" );
+    t2 += clock() - t;
+    score = ggtl_get(g, SCORE);
+    ply = ggtl_get(g, PLY_REACHED);
+    visited += ggtl_get(g, VISITED);
+    ok1( 0 < ggtl_get(g, TT_SIZE) );
+    ok( ggtl_undo(g), "undo the move" );
+
+    /* the same position searched by FIXED to the same depth */
+    ggtl_set(g, TYPE, FIXED);
+    ggtl_set(g, PLY, ply);
+    t = clock();
+    ok( ggtl_ai_move(g), "fixed search to ply %d", ply );
+    t3 += clock() - t;
+    visited2 += ggtl_get(g, VISITED);
+    ok( score == ggtl_get(g, SCORE), "same score (%d == %d)",
+      score, ggtl_get(g, SCORE) );
+  } while (!ggtl_game_over(g));
+
+  diag("MTDF visited %d states in %.2fs; FIXED %d states in %.2fs",
+    visited, t2 / (double)CLOCKS_PER_SEC,
+    visited2, t3 / (double)CLOCKS_PER_SEC);
+
+  ggtl_free(g);
+  return exit_status();
+}
@@ -0,0 +1,51 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+int main(void)
+{
+  GGTL *g, *g2;
+  int visited = 0, visited2 = 0, cutoffs = 0, first = 0, first2 = 0;
+
+  plan_no_plan();
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  g2 = reversi_init(ggtl_new(), reversi_state_new(6));
+  ok( g && g2, "setup ok" );
+
+  ggtl_set(g2, KILLERS, 1);
+  ggtl_set(g2, HISTORY, 1);
+  ok1( 1 == ggtl_get(g2, KILLERS) );
+  ok1( 1 == ggtl_get(g2, HISTORY) );
+
+  ggtl_set(g, TYPE, FIXED);
+  ggtl_set(g2, TYPE, FIXED);
+  ggtl_set(g, PLY, 5);
+  ggtl_set(g2, PLY, 5);
+
+  while (ggtl_ai_move(g)) {
+    RMove *m, *m2;
+
+    ok( ggtl_ai_move(g2), "search with killers and history" );
+    m = ggtl_peek_move(g);
+    m2 = ggtl_peek_move(g2);
+    ok( m->x == m2->x && m->y == m2->y, "the moves are the same" );
+
+    visited += ggtl_get(g, VISITED);
+    visited2 += ggtl_get(g2, VISITED);
+    first += ggtl_get(g, FIRST_CUTOFFS);
+    first2 += ggtl_get(g2, FIRST_CUTOFFS);
+    cutoffs += ggtl_get(g2, CUTOFFS);
+    ok1( ggtl_get(g2, FIRST_CUTOFFS) <= ggtl_get(g2, CUTOFFS) );
+  }
+  ok( !ggtl_ai_move(g2), "both games over" );
+
+  ok( cutoffs > 0, "got %d cutoffs", cutoffs );
+  ok( first2 > first, "%d > %d cutoffs by first move", first2, first );
+  ok( visited2 < visited, "visited %d < %d states", visited2, visited );
+
+  ggtl_free(g);
+  ggtl_free(g2);
+  return exit_status();
+}
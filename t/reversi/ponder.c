@@ -0,0 +1,86 @@
+#include <tap.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD_CREATE
+#define HAVE_THREADS 1
+#endif
+
+static GGTL *game(void)
+{
+  GGTL *g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_set(g, TT_SIZE, 65536);
+  ggtl_set_float(g, TIME, 0.05);
+  return g;
+}
+
+int main(void)
+{
+  GGTL *g, *f;
+  GGTL_MOVE *moves, *m;
+  RMove *pm, *other = NULL;
+  int plain, x, y;
+
+  plan_tests(15);
+
+  g = game();
+  ggtl_vtab(g)->hash = NULL;
+  ok( !ggtl_ponder_start(g), "pondering needs hash()" );
+  ggtl_free(g);
+
+#if HAVE_THREADS
+  /* the opponent makes the move pondered on */
+  g = game();
+  ok1( ggtl_ai_move(g) );
+  f = ggtl_fork(g);
+  ok1( ggtl_ponder_start(g) );
+  ok1( pm = ggtl_ponder_move(g) );
+  x = pm->x;
+  y = pm->y;
+  ok1( ggtl_move(f, reversi_move_new(pm->x, pm->y)) );
+  ok1( ggtl_ai_move(f) );
+  plain = ggtl_get(f, PLY_REACHED);
+  ggtl_free(f);
+
+  usleep(200000);
+  ok( ggtl_move(g, reversi_move_new(pm->x, pm->y)), "ponder hit" );
+  ok1( ggtl_ponder_move(g) );
+  ok1( ggtl_ai_move(g) );
+  ok( ggtl_get(g, PLY_REACHED) >= plain, "searched at least as deep" );
+  ok( !ggtl_ponder_move(g), "pondering over" );
+  ok( pm->x == x && pm->y == y, "move pondered on kept" );
+
+  /* it makes another */
+  moves = ggtl_get_moves(g);
+  ok1( ggtl_ponder_start(g) );
+  pm = ggtl_ponder_move(g);
+  for (m = moves; m; m = m->next) {
+    RMove *rm = m->data;
+    if (rm->x != pm->x || rm->y != pm->y) {
+      other = reversi_move_new(rm->x, rm->y);
+      break;
+    }
+  }
+  ggtl_cache_moves(g, moves);
+  ok( other && ggtl_move(g, other) && !ggtl_ponder_move(g), "ponder miss" );
+  ok1( ggtl_ai_move(g) );
+
+  /* freed while pondering */
+  ggtl_ponder_start(g);
+  ggtl_free(g);
+#else
+  (void)f;
+  (void)moves;
+  (void)m;
+  (void)pm;
+  (void)other;
+  (void)plain;
+  (void)x;
+  (void)y;
+  skip(14, "pondering needs threads");
+#endif
+
+  return exit_status();
+}
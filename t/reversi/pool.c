@@ -0,0 +1,93 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+#define GAMES 4
+
+struct game {
+  GGTL_POOL *pool;
+  int moves;
+  int over;
+};
+
+/* count the move, and submit the next one until the game is over */
+static void next(GGTL *g, void *state, void *data)
+{
+  struct game *game = data;
+
+  if (!state) {
+    game->over = 1;
+    return;
+  }
+  game->moves++;
+  if (!ggtl_pool_submit(game->pool, g, next, game)) {
+    game->over = -1;
+  }
+}
+
+static int order[3], done;
+
+static void record(GGTL *g, void *state, void *data)
+{
+  (void)g;
+  (void)state;
+  order[done++] = *(int *)data;
+}
+
+int main(void)
+{
+  GGTL_POOL *p;
+  GGTL *g[GAMES];
+  struct game games[GAMES];
+  int i, moves = 0, over = 0;
+  int ids[] = { 0, 1, 2 };
+
+  plan_tests(10);
+
+  p = ggtl_pool_new(2);
+  ok( p, "pool created" );
+
+  /* several games played to the end by two threads */
+  for (i = 0; i < GAMES; i++) {
+    g[i] = reversi_init(ggtl_new(), reversi_state_new(6));
+    ggtl_set(g[i], SEED, i + 1);
+    ggtl_set(g[i], TYPE, i % 2 ? RANDOM : ITERATIVE);
+    ggtl_set_float(g[i], TIME, 0.005);
+    games[i].pool = p;
+    games[i].moves = games[i].over = 0;
+    ok1( ggtl_pool_submit(p, g[i], next, games + i) );
+  }
+  ggtl_pool_wait(p);
+  for (i = 0; i < GAMES; i++) {
+    moves += games[i].moves;
+    over += games[i].over == 1;
+    ggtl_free(g[i]);
+  }
+  ok( over == GAMES, "all games finished" );
+  ok( moves + GAMES == ggtl_pool_get(p, POOL_JOBS), "every move counted" );
+  ok1( ggtl_pool_get(p, POOL_MAX_WAIT) >= ggtl_pool_get(p, POOL_WAIT) );
+  ok1( ggtl_pool_get(p, POOL_MAX_LATENCY) >= ggtl_pool_get(p, POOL_LATENCY) 
+       && ggtl_pool_get(p, POOL_LATENCY) > 0 );
+  ggtl_pool_free(p);
+
+  /* with one thread, the earliest deadline goes first */
+  p = ggtl_pool_new(1);
+  for (i = 0; i < 3; i++) {
+    g[i] = reversi_init(ggtl_new(), reversi_state_new(6));
+  }
+  ggtl_set_float(g[0], TIME, 0.1);
+  ggtl_set_float(g[1], TIME, 2.0);
+  ggtl_set_float(g[2], TIME, 0.01);
+  for (i = 0; i < 3; i++) {
+    ggtl_pool_submit(p, g[i], record, ids + i);
+  }
+  ggtl_pool_free(p);
+  ok( done == 3 && (order[0] == 2 || order[1] == 2) && order[2] == 1,
+      "earlier deadline searched first" );
+  for (i = 0; i < 3; i++) {
+    ggtl_free(g[i]);
+  }
+
+  return exit_status();
+}
@@ -0,0 +1,73 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+#define PARAMS "probcut.tmp"
+
+static int write_params(const char *s)
+{
+  FILE *fp = fopen(PARAMS, "w");
+  if (!fp) {
+    return 0;
+  }
+  fputs(s, fp);
+  return 0 == fclose(fp);
+}
+
+/* play a game at ply 4 with ProbCut parameters loaded; return the
+ * number of states visited, and put the total number of ProbCut
+ * cutoffs in C<cuts> */
+static int play(float t, int *cuts)
+{
+  GGTL *g;
+  int visited = 0;
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_probcut_load(g, PARAMS);
+  ggtl_set(g, TYPE, FIXED);
+  ggtl_set(g, PLY, 4);
+  ggtl_set_float(g, PROBCUT, t);
+
+  *cuts = 0;
+  while (ggtl_ai_move(g)) {
+    visited += ggtl_get(g, VISITED);
+    *cuts += ggtl_get(g, PROBCUT_CUTS);
+  }
+
+  ggtl_free(g);
+  return visited;
+}
+
+int main(void)
+{
+  GGTL *g;
+  int visited, v, cuts;
+
+  plan_tests(11);
+
+  g = ggtl_new();
+  ok1( -1 == ggtl_probcut_load(g, "no/such/file") );
+
+  ok1( write_params("4 2 1.0 0.0\n") );
+  ok( -1 == ggtl_probcut_load(g, PARAMS), "too few fields" );
+  ok1( write_params("2 3 1.0 0.0 2.0\n") );
+  ok( -1 == ggtl_probcut_load(g, PARAMS), "shallow deeper than deep" );
+
+  ok1( write_params("# deep shallow a b sigma\n\n"
+                    "4 2 1.0 0.0 2.0\n"
+                    "3 1 1.0 0.0 2.0\n") );
+  ok1( 2 == ggtl_probcut_load(g, PARAMS) );
+  ggtl_free(g);
+
+  visited = play(0, &cuts);
+  ok( visited > 0, "plain search visited %d states", visited );
+  ok1( 0 == cuts );
+
+  v = play(1.5, &cuts);
+  ok( cuts > 0, "%d probcut cutoffs", cuts );
+  ok( v < visited, "visited %d < %d states", v, visited );
+
+  remove(PARAMS);
+  return exit_status();
+}
@@ -0,0 +1,48 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+int main(void)
+{
+  GGTL *g, *g2;
+  int visited = 0, visited2 = 0;
+
+  plan_no_plan();
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  g2 = reversi_init(ggtl_new(), reversi_state_new(6));
+  ok( g && g2, "setup ok" );
+
+  ggtl_set(g, TYPE, FIXED);
+  ggtl_set(g2, TYPE, PVS);
+  ok1( PVS == ggtl_get(g2, TYPE) );
+
+  ggtl_set(g, PLY, 4);
+  ggtl_set(g2, PLY, 4);
+  ggtl_set(g, TT_SIZE, 4096);
+  ggtl_set(g2, TT_SIZE, 4096);
+
+  while (ggtl_ai_move(g)) {
+    RMove *m, *m2;
+
+    ok( ggtl_ai_move(g2), "principal variation search" );
+    m = ggtl_peek_move(g);
+    m2 = ggtl_peek_move(g2);
+    ok( m->x == m2->x && m->y == m2->y, "the moves are the same" );
+
+    visited += ggtl_get(g, VISITED);
+    visited2 += ggtl_get(g2, VISITED);
+  }
+  ok( !ggtl_ai_move(g2), "both games over" );
+
+  /* the null-window searches that fail are searched again, so PVS
+   * can visit more states than FIXED when the first move is often
+   * not the best; but not many more */
+  ok( visited2 > 0 && visited2 < visited + visited / 4,
+      "visited %d states (FIXED: %d)", visited2, visited );
+
+  ggtl_free(g);
+  ggtl_free(g2);
+  return exit_status();
+}
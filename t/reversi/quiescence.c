@@ -0,0 +1,70 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+/* play a game with quiescence search; return the most quiescence
+ * states visited by any search */
+static int play(int depth, int nodes)
+{
+  GGTL *g;
+  int most = 0;
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_vtab(g)->get_noisy_moves = &reversi_get_noisy_moves;
+  ggtl_set(g, QS_DEPTH, depth);
+  ggtl_set(g, QS_NODES, nodes);
+  ggtl_set(g, TYPE, FIXED);
+  ggtl_set(g, PLY, 2);
+
+  while (ggtl_ai_move(g)) {
+    if (ggtl_get(g, QS_VISITED) > most) {
+      most = ggtl_get(g, QS_VISITED);
+    }
+  }
+
+  ggtl_free(g);
+  return most;
+}
+
+int main(void)
+{
+  GGTL *g;
+  RState *s;
+  GGTL_MOVE *moves;
+  int most;
+
+  plan_no_plan();
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ok( g, "setup ok" );
+
+  /* no corners can be taken at the start */
+  s = ggtl_peek_state(g);
+  ok1( NULL == reversi_get_noisy_moves(s, g) );
+
+  /* corners are the only noisy moves */
+  ggtl_set(g, TYPE, RANDOM);
+  while (ggtl_ai_move(g)) {
+    s = ggtl_peek_state(g);
+    for (moves = reversi_get_noisy_moves(s, g); moves; ) {
+      GGTL_MOVE *n = sl_pop(&moves);
+      RMove *m = n->data;
+      ok( (m->x == 0 || m->x == 5) && (m->y == 0 || m->y == 5),
+        "noisy move %d,%d is a corner", m->x, m->y );
+      ggtl_cache_moves(g, n);
+    }
+  }
+  ggtl_free(g);
+
+  most = play(8, 0);
+  ok( most > 3, "quiescence search visited up to %d states", most );
+
+  most = play(8, 3);
+  ok( most == 3, "node limit respected (%d)", most );
+
+  most = play(0, 0);
+  ok( most == 0, "no quiescence search at depth 0 (%d)", most );
+
+  return exit_status();
+}
@@ -0,0 +1,103 @@
+#include <tap.h>
+#include <stdio.h>
+#include <string.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+#if HAVE_PTHREAD_H && HAVE_PTHREAD_CREATE
+#include <pthread.h>
+#define HAVE_THREADS 1
+#endif
+
+#define GAMES 4
+
+struct game {
+  int seed;
+  unsigned long sum;    /* checksum of the moves made */
+  long traced;          /* bytes of trace output */
+};
+
+/* play a game alternating between random and searched moves, with
+ * trace going to a file of its own */
+static void *play(void *arg)
+{
+  struct game *game = arg;
+  GGTL *g;
+  FILE *fp;
+  int moves = 0;
+
+  game->sum = 0;
+  game->traced = -1;
+  fp = tmpfile();
+  if (!fp) {
+    return NULL;
+  }
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_set(g, SEED, game->seed);
+  ggtl_set(g, PLY, 2);
+  ggtl_set(g, TRACE, 1);
+  ggtl_set_trace(g, fp);
+  for (;;) {
+    RMove *m;
+    ggtl_set(g, TYPE, moves++ % 2 ? FIXED : RANDOM);
+    if (!ggtl_ai_move(g)) {
+      break;
+    }
+    m = ggtl_peek_move(g);
+    game->sum = game->sum * 31 + m->x * 8 + m->y;
+  }
+  ggtl_free(g);
+
+  game->traced = ftell(fp);
+  fclose(fp);
+  return NULL;
+}
+
+int main(void)
+{
+  struct game serial[GAMES], parallel[GAMES];
+  int i, differ = 0;
+
+  plan_tests(5);
+
+  for (i = 0; i < GAMES; i++) {
+    serial[i].seed = parallel[i].seed = i + 1;
+    play(serial + i);
+    if (i && serial[i].sum != serial[0].sum) {
+      differ++;
+    }
+  }
+  ok( serial[0].traced > 0, "trace goes to the instance's sink" );
+  ok( differ, "different seeds give different games" );
+
+  play(parallel);
+  ok( parallel[0].sum == serial[0].sum, "same seed gives same game" );
+
+#if HAVE_THREADS
+  {
+    pthread_t t[GAMES];
+    int started = 0, same = 1;
+    for (i = 0; i < GAMES; i++) {
+      if (!pthread_create(t + i, NULL, play, parallel + i)) {
+        started++;
+      }
+    }
+    ok1( GAMES == started );
+    for (i = 0; i < started; i++) {
+      pthread_join(t[i], NULL);
+    }
+    for (i = 0; i < started; i++) {
+      if (parallel[i].sum != serial[i].sum
+          || parallel[i].traced != serial[i].traced) {
+        same = 0;
+      }
+    }
+    ok( same, "concurrent games match serial ones" );
+  }
+#else
+  skip(2, "built without threads");
+#endif
+
+  return exit_status();
+}
@@ -0,0 +1,150 @@
+#include <tap.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+#if HAVE_SYS_SOCKET_H && HAVE_SYS_UN_H && HAVE_NETDB_H && HAVE_POLL_H
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#define HAVE_SOCKETS 1
+#endif
+
+/* make a move with the current AI, and put its coordinates in
+ * C<x> and C<y>, and the score in C<score>. The move is undone. */
+static int search(GGTL *g, int *x, int *y, int *score)
+{
+  RMove *m;
+
+  if (!ggtl_ai_move(g)) {
+    return 0;
+  }
+  m = ggtl_peek_move(g);
+  *x = m->x;
+  *y = m->y;
+  *score = ggtl_get(g, SCORE);
+  ggtl_undo(g);
+  return 1;
+}
+
+#if HAVE_SOCKETS
+/* a worker process serving the coordinator on C<fd>; exits with 0
+ * if it searched anything */
+static pid_t worker(int fd, int listening)
+{
+  pid_t pid = fork();
+
+  if (!pid) {
+    GGTL *w = reversi_init(ggtl_new(), NULL);
+    int n;
+
+    if (listening) {
+      int l = fd;
+      fd = accept(l, NULL, NULL);
+      close(l);
+    }
+    n = ggtl_serve(w, fd);
+    ggtl_free(w);
+    _exit(n > 0 ? 0 : 1);
+  }
+  return pid;
+}
+#endif
+
+int main(void)
+{
+  GGTL *g, *c;
+  unsigned char buf[64];
+  RState *s;
+  int n;
+
+  plan_tests(7);
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  c = reversi_init(ggtl_new(), reversi_state_new(6));
+
+  n = reversi_serialize(ggtl_peek_state(g), buf, sizeof buf, g);
+  s = reversi_deserialize(buf, n, c);
+  ok( n == 11 && s
+      && reversi_hash(s, c) == reversi_hash(ggtl_peek_state(g), g),
+      "state serialized in %d bytes", n );
+  reversi_state_free(s);
+  buf[1] = 3;
+  ok( !reversi_deserialize(buf, n, c), "bad player rejected" );
+
+#if HAVE_SOCKETS
+  {
+    char path[64];
+    pid_t pids[3];
+    int fds[2], l, i, status, served = 1;
+    int same = 1, moves = 0, visited = 0;
+
+    /* a worker that has gone away */
+    socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+    close(fds[1]);
+    ggtl_add_worker(c, fds[0]);
+
+    for (i = 0; i < 2; i++) {
+      socketpair(AF_UNIX, SOCK_STREAM, 0, fds);
+      pids[i] = worker(fds[1], 0);
+      close(fds[1]);
+      ggtl_add_worker(c, fds[0]);
+    }
+
+    sprintf(path, "unix:/tmp/ggtl-remote-%ld.sock", (long)getpid());
+    unlink(path + 5);
+    l = ggtl_listen(path);
+    pids[2] = worker(l, 1);
+    close(l);
+    ok( ggtl_add_worker(c, ggtl_connect(path)), "connected to %s", path );
+    unlink(path + 5);
+
+    ggtl_set(g, PLY, 4);
+    ggtl_set(c, PLY, 4);
+    ggtl_set(c, TYPE, FIXED);
+    do {
+      int x, y, sc, x2, y2, sc2;
+
+      ggtl_set(g, TYPE, FIXED);
+      if (!search(g, &x, &y, &sc)) {
+        break;
+      }
+      if (!search(c, &x2, &y2, &sc2)) {
+        same = 0;
+        break;
+      }
+      visited += ggtl_get(c, VISITED);
+      if (x != x2 || y != y2 || sc != sc2) {
+        diag("FIXED %d,%d (%d); remote %d,%d (%d)", x, y, sc, x2, y2, sc2);
+        same = 0;
+      }
+
+      ggtl_set(g, TYPE, RANDOM);
+      moves++;
+    } while (ggtl_ai_move(g)
+             && ggtl_move(c, reversi_move_new(((RMove *)ggtl_peek_move(g))->x,
+                                              ((RMove *)ggtl_peek_move(g))->y)));
+
+    ok( moves > 10, "searched %d positions", moves );
+    ok( same, "same moves and scores as FIXED" );
+    ok( visited > 0, "workers visited %d states", visited );
+
+    ggtl_free(c);
+    for (i = 0; i < 3; i++) {
+      if (waitpid(pids[i], &status, 0) != pids[i]
+          || !WIFEXITED(status) || WEXITSTATUS(status)) {
+        served = 0;
+      }
+    }
+    ok( served, "all workers searched moves" );
+  }
+#else
+  skip(5, "no sockets");
+  ggtl_free(c);
+#endif
+
+  ggtl_free(g);
+  return exit_status();
+}
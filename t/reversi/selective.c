@@ -0,0 +1,60 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+/* play a game at ply 5 with the given option set; return the
+ * number of states visited, and put the total of counter C<key> in
+ * C<count> */
+static int play(int opt, int value, int key, int *count)
+{
+  GGTL *g;
+  int visited = 0;
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_vtab(g)->null_move = &reversi_null_move;
+  ggtl_vtab(g)->null_unmove = &reversi_null_move;
+  ggtl_set(g, TYPE, FIXED);
+  ggtl_set(g, PLY, 5);
+  ggtl_set(g, opt, value);
+
+  *count = 0;
+  while (ggtl_ai_move(g)) {
+    visited += ggtl_get(g, VISITED);
+    *count += ggtl_get(g, key);
+  }
+
+  ggtl_free(g);
+  return visited;
+}
+
+int main(void)
+{
+  int visited, v, count;
+
+  plan_tests(10);
+
+  visited = play(NULL_MOVE, 0, NULL_CUTOFFS, &count);
+  ok( visited > 0, "plain search visited %d states", visited );
+  ok1( 0 == count );
+
+  v = play(NULL_MOVE, 2, NULL_CUTOFFS, &count);
+  ok( count > 0, "%d null-move cutoffs", count );
+  ok( v < visited, "visited %d < %d states", v, visited );
+
+  v = play(LMR, 2, LMR_REDUCED, &count);
+  ok( count > 0, "%d moves reduced", count );
+  ok( v < visited, "visited %d < %d states", v, visited );
+
+  v = play(FUTILITY, 1, FUTILITY_PRUNED, &count);
+  ok( count > 0, "%d moves pruned", count );
+  ok( v < visited, "visited %d < %d states", v, visited );
+
+  /* counters are zero when turned off */
+  play(LMR, 0, LMR_REDUCED, &count);
+  ok1( 0 == count );
+  play(FUTILITY, 0, FUTILITY_PRUNED, &count);
+  ok1( 0 == count );
+
+  return exit_status();
+}
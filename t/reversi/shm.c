@@ -0,0 +1,93 @@
+#include <tap.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+#if HAVE_SYS_MMAN_H && HAVE_SHM_OPEN
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#define HAVE_SHM 1
+#endif
+
+#define ENTRIES 65536
+
+#if HAVE_SHM
+/* Returns a GGTL structure set up to search the opening to PLY 6
+ * with the table in segment C<name> (or a table of its own, if
+ * NULL). */
+static GGTL *engine(const char *name)
+{
+  GGTL *g = reversi_init(ggtl_new(), reversi_state_new(6));
+
+  ggtl_set(g, TYPE, FIXED);
+  ggtl_set(g, PLY, 6);
+  ggtl_set_string(g, TT_SHM, name);
+  ggtl_set(g, TT_SIZE, ENTRIES);
+  return g;
+}
+#endif
+
+int main(void)
+{
+  plan_tests(8);
+
+#if HAVE_SHM
+  {
+    char name[64];
+    GGTL *g, *h;
+    pid_t pid;
+    int status, visited;
+
+    sprintf(name, "/ggtl-shm-%ld", (long)getpid());
+    shm_unlink(name);
+
+    /* a table of our own, for comparison */
+    g = engine(NULL);
+    ok( ggtl_ai_move(g), "searched with a private table" );
+    visited = ggtl_get(g, VISITED);
+    ok1( 0 == ggtl_get(g, TT_SHARED_HITS) );
+    ggtl_free(g);
+
+    /* another process warms the shared table */
+    pid = fork();
+    if (!pid) {
+      g = engine(name);
+      status = ggtl_get(g, TT_SHM) && ggtl_ai_move(g);
+      ggtl_free(g);
+      _exit(status ? 0 : 1);
+    }
+    ok( waitpid(pid, &status, 0) == pid && WIFEXITED(status)
+        && !WEXITSTATUS(status), "child searched with the shared table" );
+
+    g = engine(name);
+    ok1( 1 == ggtl_get(g, TT_SHM) );
+    ok1( ENTRIES == ggtl_get(g, TT_SIZE) );
+    ggtl_ai_move(g);
+    ok( ggtl_get(g, TT_SHARED_HITS) > 0 && ggtl_get(g, VISITED) < visited,
+        "%d shared hits; visited %d states, %d alone",
+        ggtl_get(g, TT_SHARED_HITS), ggtl_get(g, VISITED), visited );
+
+    /* the segment can't be mapped with another size */
+    h = reversi_init(ggtl_new(), reversi_state_new(6));
+    ggtl_set_string(h, TT_SHM, name);
+    ggtl_set(h, TT_SIZE, ENTRIES / 2);
+    ok1( 0 == ggtl_get(h, TT_SIZE) && 0 == ggtl_get(h, TT_SHM) );
+
+    /* unsetting the name gives a private table */
+    ggtl_set_string(h, TT_SHM, NULL);
+    ggtl_set(h, TT_SIZE, ENTRIES / 2);
+    ok1( ENTRIES / 2 == ggtl_get(h, TT_SIZE) && 0 == ggtl_get(h, TT_SHM) );
+
+    ggtl_free(h);
+    ggtl_free(g);
+    shm_unlink(name);
+  }
+#else
+  skip(8, "no POSIX shared memory");
+#endif
+
+  return exit_status();
+}
@@ -0,0 +1,79 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+#define THREADS_USED 4
+
+/* play a game with the given AI type and THREADS_USED threads;
+ * returns the number of moves made, and puts the states visited by
+ * the main thread and the helpers in C<main> and C<helpers> */
+static int play(int type, int *main, int *helpers)
+{
+  GGTL *g;
+  int moves = 0;
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_set(g, TYPE, type);
+  ggtl_set(g, TT_SIZE, 65536);
+  ggtl_set(g, THREADS, THREADS_USED);
+  ggtl_set_float(g, TIME, 0.02);
+
+  *main = *helpers = 0;
+  while (ggtl_ai_move(g)) {
+    int i;
+    moves++;
+    *main += ggtl_get_thread(g, 0, VISITED);
+    for (i = 1; i < THREADS_USED; i++) {
+      *helpers += ggtl_get_thread(g, i, VISITED);
+    }
+  }
+  ggtl_free(g);
+  return moves;
+}
+
+int main(void)
+{
+  GGTL *g;
+  int moves, main, helpers;
+
+  plan_tests(13);
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_set_float(g, TIME, 0.02);
+  ggtl_set(g, THREADS, 2);
+
+  /* without a transposition table there is nothing to share */
+  ok1( ggtl_ai_move(g) );
+  ok1( -1 == ggtl_get_thread(g, 1, VISITED) );
+  ok1( ggtl_get(g, VISITED) == ggtl_get_thread(g, 0, VISITED) );
+  ok1( 0 < ggtl_get(g, NPS) );
+
+  ggtl_set(g, TT_SIZE, 4096);
+  ok1( ggtl_ai_move(g) );
+  ok1( 0 <= ggtl_get_thread(g, 1, VISITED) );
+  ok1( -1 == ggtl_get_thread(g, 2, VISITED) );
+  ok1( -1 == ggtl_get_thread(g, -1, VISITED) );
+  ggtl_free(g);
+
+  moves = play(ITERATIVE, &main, &helpers);
+  ok( moves > 0, "ITERATIVE made %d moves", moves );
+  ok( main > 0 && helpers > 0, "visited %d states, and helpers %d",
+    main, helpers );
+
+  moves = play(MTDF, &main, &helpers);
+  ok( moves > 0, "MTDF made %d moves", moves );
+  ok( main > 0 && helpers > 0, "visited %d states, and helpers %d",
+    main, helpers );
+
+  /* the game is played to the end either way */
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_set(g, THREADS, 0);
+  ggtl_set_float(g, TIME, 0.01);
+  while (ggtl_ai_move(g))
+    ;
+  ok1( ggtl_game_over(g) );
+  ggtl_free(g);
+
+  return exit_status();
+}
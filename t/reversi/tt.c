@@ -0,0 +1,50 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+int main(void)
+{
+  GGTL *g, *g2;
+  int visited = 0, visited2 = 0, hits = 0;
+
+  plan_no_plan();
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  g2 = reversi_init(ggtl_new(), reversi_state_new(6));
+  ok( g && g2, "setup ok" );
+
+  ggtl_set(g2, TT_SIZE, 4096);
+  ok1( 4096 == ggtl_get(g2, TT_SIZE) );
+  ok1( 0 == ggtl_get(g, TT_SIZE) );
+
+  ggtl_set(g, TYPE, FIXED);
+  ggtl_set(g2, TYPE, FIXED);
+  ggtl_set(g, PLY, 4);
+  ggtl_set(g2, PLY, 4);
+
+  while (ggtl_ai_move(g)) {
+    RMove *m, *m2;
+
+    ok( ggtl_ai_move(g2), "search with transposition table" );
+    m = ggtl_peek_move(g);
+    m2 = ggtl_peek_move(g2);
+    ok( m->x == m2->x && m->y == m2->y, "the moves are the same" );
+
+    visited += ggtl_get(g, VISITED);
+    visited2 += ggtl_get(g2, VISITED);
+    hits += ggtl_get(g2, TT_HITS);
+  }
+  ok( !ggtl_ai_move(g2), "both games over" );
+
+  ok( hits > 0, "got %d hits", hits );
+  ok( visited2 < visited, "visited %d < %d states", visited2, visited );
+  ok1( 0 == ggtl_get(g, TT_HITS) );
+
+  ggtl_set(g2, TT_SIZE, 0);
+  ok1( 0 == ggtl_get(g2, TT_SIZE) );
+
+  ggtl_free(g);
+  ggtl_free(g2);
+  return exit_status();
+}
@@ -0,0 +1,82 @@
+#include <tap.h>
+#include <stdio.h>
+#include <sl/sl.h>
+#include <ggtl/reversi.h>
+
+/* make a move with the current AI, and put its coordinates in
+ * C<x> and C<y>, and the score in C<score>. The move is undone. */
+static int search(GGTL *g, int *x, int *y, int *score)
+{
+  RMove *m;
+
+  if (!ggtl_ai_move(g)) {
+    return 0;
+  }
+  m = ggtl_peek_move(g);
+  *x = m->x;
+  *y = m->y;
+  *score = ggtl_get(g, SCORE);
+  ggtl_undo(g);
+  return 1;
+}
+
+int main(void)
+{
+  GGTL *g;
+  int same = 1, serial = 1, threads = 1, moves = 0;
+  int visited = 0, visited2 = 0, helpers = 0;
+
+  plan_tests(5);
+
+  g = reversi_init(ggtl_new(), reversi_state_new(6));
+  ggtl_set(g, PLY, 4);
+
+  do {
+    int x, y, sc, x2, y2, sc2, v, i;
+
+    ggtl_set(g, TYPE, FIXED);
+    if (!search(g, &x, &y, &sc)) {
+      break;
+    }
+    v = ggtl_get(g, VISITED);
+    visited += v;
+
+    /* a single thread is the same as FIXED */
+    ggtl_set(g, TYPE, YBWC);
+    ggtl_set(g, THREADS, 1);
+    search(g, &x2, &y2, &sc2);
+    if (ggtl_get(g, VISITED) != v) {
+      serial = 0;
+    }
+
+    ggtl_set(g, THREADS, 4);
+    if (!search(g, &x2, &y2, &sc2)) {
+      same = 0;
+      break;
+    }
+    visited2 += ggtl_get(g, VISITED);
+    for (i = 1; i < 4; i++) {
+      helpers += ggtl_get_thread(g, i, VISITED);
+    }
+    if (-1 != ggtl_get_thread(g, 4, VISITED)) {
+      threads = 0;
+    }
+    if (x != x2 || y != y2 || sc != sc2) {
+      diag("FIXED %d,%d (%d); YBWC %d,%d (%d)", x, y, sc, x2, y2, sc2);
+      same = 0;
+    }
+
+    ggtl_set(g, TYPE, RANDOM);
+    moves++;
+  } while (ggtl_ai_move(g));
+
+  ok( moves > 10, "searched %d positions", moves );
+  ok( same, "same moves and scores as FIXED" );
+  ok( serial, "one thread visits as many states as FIXED" );
+  ok( helpers > 0, "helpers visited %d states", helpers );
+  ok( threads, "three helper threads" );
+  diag("visited %d states; FIXED %d", visited2, visited);
+
+  ggtl_free(g);
+  return exit_status();
+}
@@ -9,7 +9,7 @@ int main(void)
 {
   GGTL_MOVE *a, *b, *c, *d;
 
-  plan_tests(4);
+  plan_tests(6);
 
   a = ggtl_mc_new(NULL);
   a->fitness = 0;
@@ -36,6 +36,16 @@ int main(void)
   ok1( b->fitness == 1 );
   ok1( c->fitness == 0 );
   ok1( d->fitness == -10 );
+
+  /* extreme values must not overflow */
+  a->fitness = GGTL_FITNESS_MIN - 1;
+  b->fitness = GGTL_FITNESS_MAX;
+  a->next = b;
+  b->next = NULL;
+
+  a = sl_mergesort(a, fitness_cmp);
+  ok1( a->fitness == GGTL_FITNESS_MAX );
+  ok1( a->next->fitness == GGTL_FITNESS_MIN - 1 );
   
   return exit_status();
 }
@@ -2,20 +2,24 @@
 use strict;
 use warnings;
 
-use Test::More tests => 24;
+use Test::More tests => 36;
 
 local $/ = '';
 my @states = qx( ./ttt-demo )
   or die 'running ttt-demo failed';
 my @states2 = qx( ./ttt-demo 1 )
   or die 'running ttt-demo2 failed';
+my @states3 = qx( ./ttt-demo copy )
+  or die 'running ttt-demo3 failed';
 
 is shift @states, "Using clone_state()\n\n";
 is shift @states2, "Using unmove()\n\n";
+is shift @states3, "Using state_size\n\n";
 
 while (<DATA>) {
   is shift @states, $_;
   is shift @states2, $_;
+  is shift @states3, $_;
 }
 
 __DATA__